@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "ix_defs.h"
+#include "ix_node_handle.h"
+#include "transaction/transaction.h"
+
+enum class Operation { FIND = 0, INSERT, DELETE };  // 三种操作：查找、插入、删除
+
+/**
+ * @brief 持有页面固定的结点句柄，离开作用域时自动解除固定，不需要手动UnpinPage和delete
+ * @note B+树的并发控制是树级的(root_latch_)，结点只固定页面、不加页面锁：合并时同一个页面会在递归的上下层被重复获取，
+ * 页面读写锁不可重入。会修改结点的guard在存续期间把页面版本号置为"正在修改"(可嵌套)，供不加锁的乐观读者检查
+ */
+class IxNodeGuard {
+   public:
+    IxNodeGuard() = default;
+
+    /** @param writing 是否会修改结点 */
+    IxNodeGuard(const IxFileHdr *file_hdr, BasicPageGuard &&guard, bool writing = false)
+        : guard_(std::move(guard)), node_(file_hdr, guard_.GetPage()), writing_(writing) {
+        if (writing_) {
+            guard_.GetPage()->BeginWrite();
+        }
+    }
+
+    IxNodeGuard(IxNodeGuard &&that) noexcept
+        : guard_(std::move(that.guard_)), node_(that.node_), writing_(std::exchange(that.writing_, false)) {}
+
+    IxNodeGuard &operator=(IxNodeGuard &&that) noexcept {
+        if (this != &that) {
+            EndWrite();
+            guard_ = std::move(that.guard_);
+            node_ = that.node_;
+            writing_ = std::exchange(that.writing_, false);
+        }
+        return *this;
+    }
+
+    ~IxNodeGuard() { EndWrite(); }
+
+    IxNodeHandle *operator->() { return &node_; }
+
+    IxNodeHandle *get() { return &node_; }
+
+    /** @brief 乐观读：记录结点的版本号，结点正在被修改时返回false */
+    bool ReadVersion(uint64_t *version) const { return guard_.GetPage()->ReadVersion(version); }
+
+    /** @brief 乐观读：检查结点自ReadVersion()以来没有被修改过 */
+    bool ValidateVersion(uint64_t version) const { return guard_.GetPage()->ValidateVersion(version); }
+
+   private:
+    void EndWrite() {
+        if (writing_) {
+            guard_.GetPage()->EndWrite();
+            writing_ = false;
+        }
+    }
+
+    BasicPageGuard guard_;
+    IxNodeHandle node_;
+    bool writing_ = false;
+};
+
+/**
+ * @brief B+树索引
+ */
+class IxIndexHandle {
+    friend class IxScan;
+    friend class IxManager;
+
+   private:
+    DiskManager *disk_manager_;
+    BufferPoolManager *buffer_pool_manager_;
+    int fd_;
+    IxFileHdr file_hdr_;  // 存了root_page，但root_page初始化为2（第0页存FILE_HDR_PAGE，第1页存LEAF_HEADER_PAGE）
+    std::mutex root_latch_;  // 用于索引并发（请自行选择并发粒度在 Tree级 或 Page级 ）
+    std::atomic<page_id_t> root_page_;  // file_hdr_.root_page的副本，供不获取root_latch_的乐观读者读取
+    std::vector<page_id_t> pending_free_pages_;  // 合并时删除、等待交还给空闲页映射的结点页号，由root_latch_保护
+
+   public:
+    IxIndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd);
+
+    // for search
+    bool GetValue(const char *key, std::vector<Rid> *result, Transaction *transaction);
+
+    page_id_t FindLeafPage(const char *key, Operation operation, Transaction *transaction);
+
+    bool FindLeafPageOptimistic(const char *key, IxNodeGuard *leaf, uint64_t *version) const;
+
+    // for insert
+    bool insert_entry(const char *key, const Rid &value, Transaction *transaction);
+
+    IxNodeGuard Split(IxNodeHandle *node);
+
+    void InsertIntoParent(IxNodeHandle *old_node, const char *key, IxNodeHandle *new_node, Transaction *transaction);
+
+    // for delete
+    bool delete_entry(const char *key, Transaction *transaction);
+
+    bool CoalesceOrRedistribute(IxNodeHandle *node, Transaction *transaction = nullptr);
+
+    bool AdjustRoot(IxNodeHandle *old_root_node);
+
+    void Redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index);
+
+    bool Coalesce(IxNodeHandle **neighbor_node, IxNodeHandle **node, IxNodeHandle **parent, int index,
+                  Transaction *transaction);
+
+    // 辅助函数，lab3执行层将使用
+    Iid lower_bound(const char *key);
+
+    Iid upper_bound(const char *key);
+
+    Iid leaf_end() const;
+
+    Iid leaf_begin() const;
+
+   private:
+    // 辅助函数
+    void UpdateRootPageNo(page_id_t root) {
+        file_hdr_.root_page = root;
+        root_page_.store(root, std::memory_order_release);
+    }
+
+    bool IsEmpty() const { return file_hdr_.root_page == IX_NO_PAGE; }
+
+    // for get/create node
+    IxNodeHandle *FetchNode(int page_no) const;
+
+    IxNodeGuard FetchNodeGuard(int page_no, bool is_dirty = false) const;
+
+    IxNodeGuard CreateNode();
+
+    // for maintain data structure
+    void maintain_parent(IxNodeHandle *node);
+
+    void erase_leaf(IxNodeHandle *leaf);
+
+    void release_node_handle(IxNodeHandle &node);
+
+    void free_pending_pages();
+
+    void maintain_child(IxNodeHandle *node, int child_idx);
+
+    // for index test
+    Rid get_rid(const Iid &iid) const;
+};
@@ -0,0 +1,26 @@
+#include "ix_scan.h"
+
+/**
+ * @brief 找到leaf page的下一个slot_no
+ */
+void IxScan::next() {
+    assert(!is_end());
+    IxNodeGuard node = ih_->FetchNodeGuard(iid_.page_no);  // 离开函数时自动取消固定
+    assert(node->IsLeafPage());
+    assert(iid_.slot_no < node->GetSize());
+    if (iid_.slot_no == 0 && iid_.page_no != ih_->file_hdr_.last_leaf) {
+        // 刚进入该叶子结点时提示缓冲池预读下一个叶子结点，扫描完该结点时它已经在缓冲池中
+        bpm_->Prefetch(PageId{ih_->fd_, node->GetNextLeaf()}, 1);
+    }
+    // increment slot no
+    iid_.slot_no++;
+    if (iid_.page_no != ih_->file_hdr_.last_leaf && iid_.slot_no == node->GetSize()) {
+        // go to next leaf
+        iid_.slot_no = 0;
+        iid_.page_no = node->GetNextLeaf();
+    }
+}
+
+Rid IxScan::rid() const {
+    return ih_->get_rid(iid_);
+}
@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// config.h
+//
+// Identification: src/include/common/config.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <string>
+
+/** Cycle detection is performed every CYCLE_DETECTION_INTERVAL milliseconds. */
+extern std::chrono::milliseconds cycle_detection_interval;
+
+/** True if logging should be enabled, false otherwise. */
+extern std::atomic<bool> enable_logging;
+
+/** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
+extern std::chrono::duration<int64_t> log_timeout;
+
+static constexpr int INVALID_FRAME_ID = -1;                                   // invalid frame id
+static constexpr int INVALID_PAGE_ID = -1;                                    // invalid page id
+static constexpr int INVALID_TXN_ID = -1;                                     // invalid transaction id
+static constexpr int INVALID_TIMESTAMP = -1;                                  // invalid transaction timestamp
+static constexpr int INVALID_LSN = -1;                                        // invalid log sequence number
+static constexpr int HEADER_PAGE_ID = 0;                                      // the header page id
+static constexpr int PAGE_SIZE = 4096;                                        // size of a data page in byte
+static constexpr int BUFFER_POOL_SIZE = 65536;                                // size of buffer pool
+static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
+static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int BUFFER_POOL_MAX_SHARDS = 16;                             // 缓冲池最多划分的分片数
+static constexpr int BUFFER_POOL_MIN_SHARD_FRAMES = 1024;                     // 自动选择分片数时，每个分片至少拥有的帧数
+static constexpr bool BUFFER_POOL_USE_HUGE_PAGES = true;                      // 缓冲池帧数据区是否尝试使用2MB大页
+static constexpr bool BUFFER_POOL_NUMA_INTERLEAVE = true;                     // 缓冲池帧数据区是否交错分配到所有NUMA结点
+static constexpr int BUFFER_POOL_RESIZE_TIMEOUT_MS = 1000;                    // 缩小缓冲池时等待被固定的帧解除固定的默认时长(毫秒)
+static constexpr int BUFFER_POOL_FLUSHER_CLEAN_PERCENT = 10;                  // 后台写回线程为每个分片保持的干净可淘汰帧比例(%)，为0时不启动该线程
+static constexpr int BUFFER_POOL_FLUSHER_INTERVAL_MS = 10;                    // 后台写回线程的检查周期(毫秒)
+static constexpr int BUFFER_POOL_FLUSHER_BATCH = 64;                          // 后台写回线程每个分片每轮最多写回的脏页数
+static constexpr int BUFFER_POOL_READ_AHEAD_PAGES = 32;                       // 顺序访问时一次预读的页数，为0时不预读
+static constexpr int BUFFER_POOL_PREFETCH_QUEUE_SIZE = 64;                    // 等待处理的预读请求上限，超过时丢弃新的预读请求
+static constexpr bool BUFFER_POOL_STATS_TIMING = true;                        // 是否统计缓冲池操作和磁盘I/O的延迟直方图(计数器总是统计)
+static constexpr int BUFFER_POOL_HOT_PAGES_DUMP_INTERVAL_MS = 60000;          // 周期性转储缓冲池热页列表的间隔(毫秒)
+static constexpr int BUFFER_POOL_WARM_UP_BATCH = 256;                         // 预热时一批同时读入的页数
+static constexpr int OPTIMISTIC_READ_RETRIES = 8;                             // 乐观读被写者打断的重试次数，超过后退回到加锁读
+static constexpr bool DISK_DIRECT_IO = false;                                // 表文件和索引文件是否以O_DIRECT打开，由缓冲池作为唯一的缓存
+static constexpr int DIRECT_IO_ALIGNMENT = 4096;                              // 直接I/O要求的缓冲区地址、长度和文件偏移对齐
+static constexpr int DISK_EXTENT_PAGES = 256;                                 // 文件增长时一次用fallocate预留的最少页数，为0时不预留
+static constexpr int DISK_MAX_EXTENT_PAGES = 16384;                           // 大文件按已预留大小的1/8增长，一次最多预留的页数
+static constexpr bool RM_PAGE_CHECKSUM = true;                                // 新建的记录文件是否带页面校验和(CRC32C)，保存在文件头中，
+                                                                              // 打开已有文件时按文件头决定，不影响此前创建的文件
+static constexpr int RM_BULK_LOAD_BATCH_PAGES = 256;                          // 批量加载记录时攒满多少页写入一次文件
+static constexpr int IO_QUEUE_DEPTH = 256;                                    // 异步I/O引擎允许同时在途的最大请求数(io_uring队列深度)
+static constexpr int IO_WORKER_THREADS = 4;                                   // io_uring不可用时，后备线程池引擎的工作线程数
+
+using frame_id_t = int32_t;  // frame id type, 帧页ID, 页在BufferPool中的存储单元称为帧,一帧对应一页
+using page_id_t = int32_t;   // page id type , 页ID
+using txn_id_t = int32_t;    // transaction id type
+using lsn_t = int32_t;       // log sequence number type
+using slot_offset_t = size_t;  // slot offset type
+using oid_t = uint16_t;
+using timestamp_t = int32_t;  // timestamp type, used for transaction concurrency
+
+// log file
+static const std::string LOG_FILE_NAME = "db.log";
+
+// replacer: "LRU", "CLOCK", "LRU-K" or "2Q"
+static const std::string REPLACER_TYPE = "LRU";
+static constexpr int LRU_K = 2;                                               // LRU-K替换策略中的K
+static constexpr int TWO_QUEUE_A1_PERCENT = 25;                               // 2Q替换策略中A1队列的目标长度占replacer容量的百分比
@@ -0,0 +1,115 @@
+#include "storage/crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>  // for _mm_crc32_u64/_mm_crc32_u8
+#endif
+
+namespace {
+
+constexpr uint32_t CRC32C_POLY = 0x82f63b78;  // Castagnoli多项式(反射形式)
+
+struct Crc32cTable {
+    uint32_t entries[256];
+
+    Crc32cTable() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ (crc & 1 ? CRC32C_POLY : 0);
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+uint32_t crc32c_sw(const char *data, size_t len, uint32_t crc) {
+    static const Crc32cTable table;
+    for (size_t i = 0; i < len; i++) {
+        crc = table.entries[(crc ^ static_cast<uint8_t>(data[i])) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+/** 三路并行时每一路的长度(8的倍数)：三段恰好覆盖一个4KB页面中除页头以外的部分 */
+constexpr size_t CRC32C_BLOCK = 1360;
+
+__attribute__((target("sse4.2"))) uint64_t crc32c_hw_serial(const char *data, size_t len, uint64_t crc) {
+    for (; len >= sizeof(uint64_t); data += sizeof(uint64_t), len -= sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc = _mm_crc32_u64(crc, word);
+    }
+    for (; len > 0; data++, len--) {
+        crc = _mm_crc32_u8(static_cast<uint32_t>(crc), static_cast<uint8_t>(*data));
+    }
+    return crc;
+}
+
+/**
+ * @brief 把CRC状态向后推进CRC32C_BLOCK个0字节：该运算是线性的，按状态的4个字节查表后异或
+ */
+struct Crc32cShiftTable {
+    uint32_t entries[4][256];
+
+    Crc32cShiftTable() {
+        static const char zeros[CRC32C_BLOCK] = {};
+        for (int k = 0; k < 4; k++) {
+            for (uint32_t v = 0; v < 256; v++) {
+                entries[k][v] = static_cast<uint32_t>(crc32c_hw_serial(zeros, CRC32C_BLOCK, v << (8 * k)));
+            }
+        }
+    }
+
+    uint32_t shift(uint32_t crc) const {
+        return entries[0][crc & 0xff] ^ entries[1][(crc >> 8) & 0xff] ^ entries[2][(crc >> 16) & 0xff] ^
+               entries[3][crc >> 24];
+    }
+};
+
+/**
+ * @brief crc32指令的延迟是3个周期、吞吐是每周期1条，单条依赖链只能用到1/3的吞吐；
+ * 长数据按3*CRC32C_BLOCK分段，三段各自独立计算后用Crc32cShiftTable合并
+ */
+__attribute__((target("sse4.2"))) uint32_t crc32c_hw(const char *data, size_t len, uint32_t crc) {
+    static const Crc32cShiftTable table;
+    uint64_t crc0 = crc;
+    for (; len >= 3 * CRC32C_BLOCK; data += 3 * CRC32C_BLOCK, len -= 3 * CRC32C_BLOCK) {
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+        for (size_t i = 0; i < CRC32C_BLOCK; i += sizeof(uint64_t)) {
+            uint64_t word0, word1, word2;
+            memcpy(&word0, data + i, sizeof(word0));
+            memcpy(&word1, data + CRC32C_BLOCK + i, sizeof(word1));
+            memcpy(&word2, data + 2 * CRC32C_BLOCK + i, sizeof(word2));
+            crc0 = _mm_crc32_u64(crc0, word0);
+            crc1 = _mm_crc32_u64(crc1, word1);
+            crc2 = _mm_crc32_u64(crc2, word2);
+        }
+        crc0 = table.shift(table.shift(static_cast<uint32_t>(crc0)) ^ static_cast<uint32_t>(crc1)) ^
+               static_cast<uint32_t>(crc2);
+    }
+    return static_cast<uint32_t>(crc32c_hw_serial(data, len, crc0));
+}
+#endif
+
+using Crc32cFunc = uint32_t (*)(const char *, size_t, uint32_t);
+
+/** 第一次调用时按CPU特性选择实现 */
+Crc32cFunc select_crc32c() {
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("sse4.2")) {
+        return crc32c_hw;
+    }
+#endif
+    return crc32c_sw;
+}
+
+}  // namespace
+
+uint32_t Crc32c(const char *data, size_t len, uint32_t crc) {
+    static const Crc32cFunc impl = select_crc32c();
+    return ~impl(data, len, ~crc);
+}
@@ -0,0 +1,22 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// crc32c.h
+//
+// Identification: src/storage/crc32c.h
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 计算data[0, len)的CRC32C(Castagnoli多项式)，crc为之前若干段数据的结果，用于分段计算
+ * @note CPU支持SSE4.2时使用crc32指令(每条指令处理8字节)，否则使用查表的软件实现；两者结果相同
+ */
+uint32_t Crc32c(const char *data, size_t len, uint32_t crc = 0);
@@ -0,0 +1,152 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// direct_io_bench.cpp
+//
+// Identification: src/storage/direct_io_bench.cpp
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief 比较缓冲I/O与直接I/O(O_DIRECT)下缓冲池的随机读性能
+ *
+ * 用法: direct_io_bench [num_pages] [pool_size] [num_ops] [num_threads]
+ * 先生成一个num_pages页的数据文件，然后分别以两种模式打开，num_threads个线程在所有页面上做num_ops次随机FetchPage，
+ * 其中80%的访问落在20%的热点页面上。缓冲I/O模式下缓冲池未命中的页面可能由操作系统页缓存提供(同一页面缓存两份)，
+ * 直接I/O模式下每次未命中都是一次真正的磁盘读，缓冲池是唯一的缓存。
+ * 每种模式开始前用posix_fadvise(POSIX_FADV_DONTNEED)清除该文件在页缓存中的页面，两种模式都从冷缓存开始
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+namespace {
+
+const std::string BENCH_FILE_NAME = "direct_io_bench.db";
+
+/** @brief 生成num_pages页的数据文件，每页开头写入页号，便于检查读到的页面 */
+void CreateBenchFile(int num_pages) {
+    DiskManager disk_manager(false);
+    if (disk_manager.is_file(BENCH_FILE_NAME)) {
+        disk_manager.destroy_file(BENCH_FILE_NAME);
+    }
+    disk_manager.create_file(BENCH_FILE_NAME);
+    int fd = disk_manager.open_file(BENCH_FILE_NAME);
+    std::vector<char> buf(PAGE_SIZE, 0);
+    for (int page_no = 0; page_no < num_pages; page_no++) {
+        memcpy(buf.data(), &page_no, sizeof(page_no));
+        disk_manager.write_page(fd, page_no, buf.data(), PAGE_SIZE);
+    }
+    fsync(fd);
+    disk_manager.close_file(fd);
+}
+
+/** @brief 清除数据文件在操作系统页缓存中的页面(不需要root权限) */
+void DropPageCache() {
+    int fd = open(BENCH_FILE_NAME.c_str(), O_RDONLY);
+    if (fd != -1) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+struct BenchResult {
+    bool direct;        // 文件是否真的以O_DIRECT打开
+    double seconds;
+    size_t hits;
+    size_t misses;
+    size_t errors;      // 读到的页号与请求不一致的次数
+};
+
+BenchResult RunBench(bool direct_io, int num_pages, int pool_size, int num_ops, int num_threads) {
+    DropPageCache();
+    DiskManager disk_manager(direct_io);
+    BufferPoolManager bpm(pool_size, &disk_manager);
+    int fd = disk_manager.open_file(BENCH_FILE_NAME);
+    disk_manager.set_fd2pageno(fd, num_pages);
+
+    std::atomic<size_t> errors{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; tid++) {
+        threads.emplace_back([&, tid]() {
+            std::mt19937 rng(tid + 1);
+            std::uniform_int_distribution<int> percent(0, 99);
+            int hot_pages = std::max(1, num_pages / 5);
+            std::uniform_int_distribution<int> hot(0, hot_pages - 1);
+            std::uniform_int_distribution<int> any(0, num_pages - 1);
+            for (int i = tid; i < num_ops; i += num_threads) {
+                int page_no = percent(rng) < 80 ? hot(rng) : any(rng);
+                PageId page_id{fd, page_no};
+                Page *page = bpm.FetchPage(page_id);
+                if (page == nullptr) {
+                    errors++;
+                    continue;
+                }
+                int stored;
+                memcpy(&stored, page->GetData(), sizeof(stored));
+                if (stored != page_no) {
+                    errors++;
+                }
+                bpm.UnpinPage(page_id, false);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    BufferPoolStats::Snapshot stats = bpm.GetStats();
+    BenchResult result{disk_manager.is_direct_io(fd), seconds, stats.Total(BufferPoolStats::HIT),
+                       stats.Total(BufferPoolStats::MISS), errors.load()};
+    disk_manager.close_file(fd);
+    return result;
+}
+
+void PrintResult(const char *mode, const BenchResult &result, int num_ops) {
+    printf("%-10s %-8s %10.3f %12.0f %10zu %10zu %8zu\n", mode, result.direct ? "yes" : "no", result.seconds,
+           num_ops / result.seconds, result.hits, result.misses, result.errors);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    int num_pages = argc > 1 ? atoi(argv[1]) : 65536;
+    int pool_size = argc > 2 ? atoi(argv[2]) : num_pages / 4;
+    int num_ops = argc > 3 ? atoi(argv[3]) : 1000000;
+    int num_threads = argc > 4 ? atoi(argv[4]) : 4;
+
+    printf("pages=%d (%d MB) pool=%d ops=%d threads=%d\n", num_pages, num_pages / (1024 * 1024 / PAGE_SIZE),
+           pool_size, num_ops, num_threads);
+    CreateBenchFile(num_pages);
+
+    BenchResult buffered = RunBench(false, num_pages, pool_size, num_ops, num_threads);
+    BenchResult direct = RunBench(true, num_pages, pool_size, num_ops, num_threads);
+
+    printf("%-10s %-8s %10s %12s %10s %10s %8s\n", "mode", "O_DIRECT", "seconds", "ops/s", "hits", "misses", "errors");
+    PrintResult("buffered", buffered, num_ops);
+    PrintResult("direct", direct, num_ops);
+    if (!direct.direct) {
+        printf("note: the filesystem does not support O_DIRECT, the direct run fell back to buffered I/O\n");
+    }
+
+    DiskManager disk_manager(false);
+    disk_manager.destroy_file(BENCH_FILE_NAME);
+    return buffered.errors + direct.errors == 0 ? 0 : 1;
+}
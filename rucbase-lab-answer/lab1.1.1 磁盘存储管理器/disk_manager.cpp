@@ -1,277 +1,576 @@
-#include "storage/disk_manager.h"
-
-#include <assert.h>    // for assert
-#include <string.h>    // for memset
-#include <sys/stat.h>  // for stat
-#include <unistd.h>    // for lseek
-
-#include "defs.h"
-using namespace std;
-
-
-DiskManager::DiskManager() { memset(fd2pageno_, 0, MAX_FD * (sizeof(std::atomic<page_id_t>) / sizeof(char))); }
-
-/**
- * @brief Write the contents of the specified page into disk file
- *
- */
-void DiskManager::write_page(int fd, page_id_t page_no, const char *offset, int num_bytes) {
-    // Todo:
-    // 1.lseek()定位到文件头，通过(fd,page_no)可以定位指定页面及其在磁盘文件中的偏移量
-    // 2.调用write()函数
-    // 注意处理异常
-    
-    //从内存中的offset位置，读取num_bytes字节，写入diskfile中
-    //移动文件指针到(page_no) * page_size
-    //从文件指针起始的num_bytes 一次性写入磁盘文件中
-    //写入时确保num_bytes合法
-
-    // file_offset 是文件内的偏移量，用于定位写操作在文件中的位置。
-    // offset 是内存中的数据指针(内存缓冲区)，用于定位要写入的数据在内存中的位置。
-
-        off_t file_offset = page_no * PAGE_SIZE; //page_no 从0开始， file_offset指向磁盘中文件页面位置
-        //写入数据就在file_offset 后面写入
-
-        //将文件指针移动到file_offset处
-        if(lseek(fd, file_offset, SEEK_SET) == -1) throw UnixError();
-
-        //写入数据(将offset的num_bytes字节写回磁盘)
-        ssize_t writen_bytes = write(fd, offset, num_bytes);
-        if(writen_bytes == -1 || writen_bytes != num_bytes){
-            //perror("write");
-            throw UnixError();
-        }
-        
-        // //确保数据写入磁盘
-        // if(fsync(fd) == -1){
-        //     //perror("fsync");
-        //     return ;
-        // }
-}
-
-
-
-/**
- * @brief Read the contents of the specified page into the given memory area
- */
-void DiskManager::read_page(int fd, page_id_t page_no, char *offset, int num_bytes) {
-    // Todo:
-    // 1.lseek()定位到文件头，通过(fd,page_no)可以定位指定页面及其在磁盘文件中的偏移量
-    // 2.调用read()函数
-    // 注意处理异常
-        if(num_bytes < 0 || num_bytes > PAGE_SIZE)  //读取字节数不合法
-            throw UnixError();
-        
-        off_t file_offset = page_no * PAGE_SIZE;
-
-        //移动文件指针
-        if(lseek(fd, file_offset, SEEK_SET) == -1){
-            throw UnixError();
-        }
-
-        //读取数据到offset
-        ssize_t read_bytes = read(fd, offset, num_bytes);
-        if(read_bytes == -1 || read_bytes != num_bytes)
-            throw UnixError();
-    
-}
-
-/**
- * @brief Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
- */
-page_id_t DiskManager::AllocatePage(int fd) {
-    // Todo:
-    // 简单的自增分配策略，指定文件的页面编号加1
-
-    return fd2pageno_[fd] ++ ;
-}
-
-/**
- * @brief Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
- * This does not actually need to do anything for now.
- */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
-
-bool DiskManager::is_dir(const std::string &path) {
-    struct stat st;
-    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
-}
-
-void DiskManager::create_dir(const std::string &path) {
-    // Create a subdirectory
-    std::string cmd = "mkdir " + path;
-    if (system(cmd.c_str()) < 0) {  // 创建一个名为path的目录
-        throw UnixError();
-    }
-}
-
-void DiskManager::destroy_dir(const std::string &path) {
-    std::string cmd = "rm -r " + path;
-    if (system(cmd.c_str()) < 0) {
-        throw UnixError();
-    }
-}
-
-/**
- * @brief 用于判断指定路径文件是否存在 
- */
-bool DiskManager::is_file(const std::string &path) {
-    // Todo:
-    // 用struct stat获取文件信息
-    struct stat statbuf;
-    int ret = stat(path.c_str(), &statbuf);
-    if(ret == 0){
-        //perror("comes form is_file : stat");
-        return S_ISREG(statbuf.st_mode);
-    }
-    //判断是否为常规文件
-    return false;
-}
-
-/**
- * @brief 用于创建指定路径文件
- */
-void DiskManager::create_file(const std::string &path) {
-    // Todo:
-    // 调用open()函数，使用O_CREAT模式
-    // 注意不能重复创建相同文件
-    //文件已经存在
-    if(is_file(path)) throw FileExistsError(path);
-
-    //使用open()创建文件
-    int fd = open(path.c_str(), O_CREAT, 0777);
-    if(fd == -1){
-        //perror("open");
-        throw UnixError();
-    }
-    //关闭文件
-    close(fd);
-
-}
-
-/**
- * @brief 用于删除指定路径文件 
- */
-void DiskManager::destroy_file(const std::string &path) {
-    // Todo:
-    // 调用unlink()函数
-    // 注意不能删除未关闭的文件
-    //文件在打开文件列表
-    if(path2fd_.find(path) != path2fd_.end()) 
-        throw UnixError();
-
-    //文件不存在
-    if(is_file(path) == false) 
-        throw FileNotFoundError(path);
-
-    if(unlink(path.c_str()) == -1){
-        //perror("unlink");
-        throw UnixError();
-    }
-
-}
-
-/**
- * @brief 用于打开指定路径文件
- */
-int DiskManager::open_file(const std::string &path) {
-    // Todo:
-    // 调用open()函数，使用O_RDWR模式
-    // 注意不能重复打开相同文件，并且需要更新文件打开列表
-    //文件在打开文件列表
-    if(path2fd_.count(path)){
-        //cerr << "file not close" << endl;
-        throw UnixError();
-    }
-
-    //文件不存在
-    if(is_file(path) == false){
-        //cerr << "comes form open_file : file not exists" << endl;
-        throw FileNotFoundError(path);
-        //return -1;
-    }
-
-    int fd = open(path.c_str(), O_RDWR, 0777);
-    if(fd == -1){
-        //perror("open");
-        throw UnixError();
-    }else{
-        path2fd_.insert(make_pair(path, fd));
-	    fd2path_.insert(make_pair(fd,path));
-    }
-    return fd;
-}
-
-/**
- * @brief 用于关闭指定路径文件
- */
-void DiskManager::close_file(int fd) {
-    // Todo:
-    // 调用close()函数
-    // 注意不能关闭未打开的文件，并且需要更新文件打开列表
-    //文件在打开文件列表
-    if(!fd2path_.count(fd)){
-        //cerr << "file not close" << endl;
-        throw FileNotOpenError(fd);
-    }
-    //把文件从打开列表中删除
-    path2fd_.erase(fd2path_[fd]);
-    fd2path_.erase(fd);
-    close(fd);
-
-}
-
-int DiskManager::GetFileSize(const std::string &file_name) {
-    struct stat stat_buf;
-    int rc = stat(file_name.c_str(), &stat_buf);
-    return rc == 0 ? stat_buf.st_size : -1;
-}
-
-std::string DiskManager::GetFileName(int fd) {
-    if (!fd2path_.count(fd)) {
-        throw FileNotOpenError(fd);
-    }
-    return fd2path_[fd];
-}
-
-int DiskManager::GetFileFd(const std::string &file_name) {
-    if (!path2fd_.count(file_name)) {
-        return open_file(file_name);
-    }
-    return path2fd_[file_name];
-}
-
-bool DiskManager::ReadLog(char *log_data, int size, int offset, int prev_log_end) {
-    // read log file from the previous end
-    if (log_fd_ == -1) {
-        log_fd_ = open_file(LOG_FILE_NAME);
-    }
-    offset += prev_log_end;
-    int file_size = GetFileSize(LOG_FILE_NAME);
-    if (offset >= file_size) {
-        return false;
-    }
-
-    size = std::min(size, file_size - offset);
-    lseek(log_fd_, offset, SEEK_SET);
-    ssize_t bytes_read = read(log_fd_, log_data, size);
-    if (bytes_read != size) {
-        throw UnixError();
-    }
-    return true;
-}
-
-void DiskManager::WriteLog(char *log_data, int size) {
-    if (log_fd_ == -1) {
-        log_fd_ = open_file(LOG_FILE_NAME);
-    }
-
-    // write from the file_end
-    lseek(log_fd_, 0, SEEK_END);
-    ssize_t bytes_write = write(log_fd_, log_data, size);
-    if (bytes_write != size) {
-        throw UnixError();
-    }
-}
+#include "storage/disk_manager.h"
+
+#include <assert.h>    // for assert
+#include <errno.h>     // for errno
+#include <fcntl.h>     // for fallocate
+#include <limits.h>    // for IOV_MAX
+#include <string.h>    // for memset
+#include <sys/stat.h>  // for stat
+#include <unistd.h>    // for pread/pwrite
+
+#include <algorithm>
+
+#include "defs.h"
+using namespace std;
+
+
+DiskManager::DiskManager(bool direct_io) : direct_io_(direct_io) {
+    memset(fd2pageno_, 0, MAX_FD * (sizeof(std::atomic<page_id_t>) / sizeof(char)));
+}
+
+namespace {
+/** 直接I/O的中转缓冲区，每个线程一个 */
+struct alignas(DIRECT_IO_ALIGNMENT) BounceBuffer {
+    char data[PAGE_SIZE];
+};
+thread_local BounceBuffer bounce_buffer;
+}  // namespace
+
+/**
+ * @brief Write the contents of the specified page into disk file
+ *
+ */
+void DiskManager::write_page(int fd, page_id_t page_no, const char *offset, int num_bytes) {
+    // Todo:
+    // 1.lseek()定位到文件头，通过(fd,page_no)可以定位指定页面及其在磁盘文件中的偏移量
+    // 2.调用write()函数
+    // 注意处理异常
+
+    //从内存中的offset位置，读取num_bytes字节，写入diskfile中
+    //写入时确保num_bytes合法
+    //使用pwrite()按页面偏移量直接写入，不移动共享的文件指针，多个线程写同一文件时不会相互干扰
+
+    // file_offset 是文件内的偏移量，用于定位写操作在文件中的位置。
+    // offset 是内存中的数据指针(内存缓冲区)，用于定位要写入的数据在内存中的位置。
+
+        if(fd2direct_[fd] && !is_aligned(offset, num_bytes)){
+            bounce_write(fd, page_no, offset, num_bytes); //直接I/O不能直接写不对齐的缓冲区
+            return;
+        }
+
+        off_t file_offset = static_cast<off_t>(page_no) * PAGE_SIZE; //page_no 从0开始， file_offset指向磁盘中文件页面位置
+
+        //写入数据(将offset的num_bytes字节写回磁盘)
+        ssize_t writen_bytes = pwrite(fd, offset, num_bytes, file_offset);
+        if(writen_bytes == -1 || writen_bytes != num_bytes){
+            //perror("write");
+            throw UnixError();
+        }
+}
+
+
+
+/**
+ * @brief Read the contents of the specified page into the given memory area
+ */
+void DiskManager::read_page(int fd, page_id_t page_no, char *offset, int num_bytes) {
+    // Todo:
+    // 1.lseek()定位到文件头，通过(fd,page_no)可以定位指定页面及其在磁盘文件中的偏移量
+    // 2.调用read()函数
+    // 注意处理异常
+        if(num_bytes < 0 || num_bytes > PAGE_SIZE)  //读取字节数不合法
+            throw UnixError();
+        
+        if(fd2direct_[fd] && !is_aligned(offset, num_bytes)){
+            bounce_read(fd, page_no, offset, num_bytes); //直接I/O不能直接读到不对齐的缓冲区
+            return;
+        }
+
+        off_t file_offset = static_cast<off_t>(page_no) * PAGE_SIZE;
+
+        //读取数据到offset，pread()不依赖文件指针
+        ssize_t read_bytes = pread(fd, offset, num_bytes, file_offset);
+        if(read_bytes == -1 || read_bytes != num_bytes)
+            throw UnixError();
+    
+}
+
+/**
+ * @brief 批量读取整页，同一文件中页号连续的页面合并为一次preadv
+ */
+void DiskManager::read_pages(std::vector<PageIORequest> requests) { batch_io(requests, false); }
+
+/**
+ * @brief 批量写回整页，同一文件中页号连续的页面合并为一次pwritev
+ */
+void DiskManager::write_pages(std::vector<PageIORequest> requests) { batch_io(requests, true); }
+
+void DiskManager::sync_file(int fd) {
+    if (fdatasync(fd) == -1) {
+        throw UnixError();
+    }
+}
+
+void DiskManager::bounce_read(int fd, page_id_t page_no, char *offset, int num_bytes) {
+    off_t file_offset = static_cast<off_t>(page_no) * PAGE_SIZE;
+    ssize_t read_bytes = pread(fd, bounce_buffer.data, PAGE_SIZE, file_offset);
+    if (read_bytes == -1 || read_bytes < num_bytes) {
+        throw UnixError();
+    }
+    memcpy(offset, bounce_buffer.data, num_bytes);
+}
+
+void DiskManager::bounce_write(int fd, page_id_t page_no, const char *offset, int num_bytes) {
+    off_t file_offset = static_cast<off_t>(page_no) * PAGE_SIZE;
+    ssize_t read_bytes = 0;
+    if (num_bytes < PAGE_SIZE) {
+        read_bytes = pread(fd, bounce_buffer.data, PAGE_SIZE, file_offset); //保留页面中不被覆盖的部分
+        if (read_bytes == -1) {
+            throw UnixError();
+        }
+    }
+    memset(bounce_buffer.data + read_bytes, 0, PAGE_SIZE - read_bytes);  // 文件末尾之后的部分补0
+    memcpy(bounce_buffer.data, offset, num_bytes);
+    if (pwrite(fd, bounce_buffer.data, PAGE_SIZE, file_offset) != PAGE_SIZE) {
+        throw UnixError();
+    }
+}
+
+std::future<void> DiskManager::submit_read(int fd, page_id_t page_no, char *offset, int num_bytes) {
+    if (num_bytes < 0 || num_bytes > PAGE_SIZE) throw UnixError();
+    if (fd2direct_[fd] && !is_aligned(offset, num_bytes)) {
+        //不对齐的请求不能交给I/O引擎，同步地经过中转缓冲区完成
+        std::promise<void> done;
+        try {
+            bounce_read(fd, page_no, offset, num_bytes);
+            done.set_value();
+        } catch (...) {
+            done.set_exception(std::current_exception());
+        }
+        return done.get_future();
+    }
+    return io_engine()->submit_read(fd, page_no, offset, num_bytes);
+}
+
+std::future<void> DiskManager::submit_write(int fd, page_id_t page_no, const char *offset, int num_bytes) {
+    if (fd2direct_[fd] && !is_aligned(offset, num_bytes)) {
+        std::promise<void> done;
+        try {
+            bounce_write(fd, page_no, offset, num_bytes);
+            done.set_value();
+        } catch (...) {
+            done.set_exception(std::current_exception());
+        }
+        return done.get_future();
+    }
+    return io_engine()->submit_write(fd, page_no, offset, num_bytes);
+}
+
+IOEngine *DiskManager::io_engine() {
+    std::call_once(io_engine_once_, [this]() { io_engine_ = IOEngine::Create(IO_QUEUE_DEPTH, IO_WORKER_THREADS); });
+    return io_engine_.get();
+}
+
+void DiskManager::batch_io(std::vector<PageIORequest> &requests, bool is_write) {
+    std::sort(requests.begin(), requests.end(), [](const PageIORequest &a, const PageIORequest &b) {
+        return a.fd != b.fd ? a.fd < b.fd : a.page_no < b.page_no;
+    });
+
+    std::vector<struct iovec> iov;
+    iov.reserve(std::min<size_t>(requests.size(), IOV_MAX));
+    size_t i = 0;
+    auto unaligned = [this](const PageIORequest &request) {
+        return fd2direct_[request.fd] && !is_aligned(request.buf, PAGE_SIZE);
+    };
+    while (i < requests.size()) {
+        if (unaligned(requests[i])) {
+            //直接I/O文件上不对齐的缓冲区单独经过中转缓冲区读写
+            if (is_write) {
+                bounce_write(requests[i].fd, requests[i].page_no, requests[i].buf, PAGE_SIZE);
+            } else {
+                bounce_read(requests[i].fd, requests[i].page_no, requests[i].buf, PAGE_SIZE);
+            }
+            i++;
+            continue;
+        }
+        //从requests[i]开始收集一段页号连续的请求，长度不超过IOV_MAX
+        size_t j = i;
+        iov.clear();
+        do {
+            iov.push_back({requests[j].buf, PAGE_SIZE});
+            j++;
+        } while (j < requests.size() && requests[j].fd == requests[i].fd &&
+                 requests[j].page_no == requests[j - 1].page_no + 1 && iov.size() < IOV_MAX &&
+                 !unaligned(requests[j]));
+        vectored_io(requests[i].fd, requests[i].page_no, iov.data(), static_cast<int>(iov.size()), is_write);
+        i = j;
+    }
+}
+
+void DiskManager::vectored_io(int fd, page_id_t page_no, struct iovec *iov, int iovcnt, bool is_write) {
+    off_t file_offset = static_cast<off_t>(page_no) * PAGE_SIZE;
+    while (iovcnt > 0) {
+        ssize_t bytes = is_write ? pwritev(fd, iov, iovcnt, file_offset) : preadv(fd, iov, iovcnt, file_offset);
+        if (bytes <= 0) {
+            //出错，或读到了文件末尾
+            throw UnixError();
+        }
+        file_offset += bytes;
+        //跳过已经完整传输的iovec，剩余部分继续传输
+        while (iovcnt > 0 && static_cast<size_t>(bytes) >= iov->iov_len) {
+            bytes -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = static_cast<char *>(iov->iov_base) + bytes;
+            iov->iov_len -= bytes;
+        }
+    }
+}
+
+/**
+ * @brief Allocate new page (operations like create index/table)
+ * For now just keep an increasing counter
+ */
+page_id_t DiskManager::AllocatePage(int fd) {
+    // Todo:
+    // 简单的自增分配策略，指定文件的页面编号加1
+
+    std::unique_lock lock{fsm_latch_};
+    auto it = fsm_.find(fd);
+    if (it == fsm_.end() || it->second.num_free == 0) {
+        lock.unlock();
+        page_id_t page_no = fd2pageno_[fd] ++ ; //没有被释放的页面，在文件末尾分配
+        reserve_extent(fd, page_no);
+        return page_no;
+    }
+
+    FreeSpaceMap &fsm = it->second;
+    page_id_t page_no = fsm.last_allocated + 1;
+    //优先分配紧随上一次分配的页面，连续分配的页面在文件中也连续；否则从页号最小的空闲页开始一段新的连续分配
+    if (fsm.last_allocated == INVALID_PAGE_ID || !is_free(fsm, page_no)) {
+        while (fsm.bits[fsm.scan_hint] == 0) {
+            fsm.scan_hint++;
+        }
+        page_no = static_cast<page_id_t>(fsm.scan_hint * 8 + __builtin_ctz(fsm.bits[fsm.scan_hint]));
+    }
+    set_free(fsm, page_no, false);
+    fsm.last_allocated = page_no;
+    if (page_no >= fd2pageno_[fd]) {
+        fd2pageno_[fd] = page_no + 1; //映射来自磁盘上的.fsm文件，自增分配不能再分配到该页
+    }
+    return page_no;
+}
+
+page_id_t DiskManager::AllocatePages(int fd, int num_pages) {
+    page_id_t page_no = fd2pageno_[fd].fetch_add(num_pages);
+    reserve_extent(fd, page_no + num_pages - 1);
+    return page_no;
+}
+
+void DiskManager::DeallocatePage(int fd, page_id_t page_no) {
+    if (page_no < 0) {
+        throw InternalError("DiskManager::DeallocatePage: invalid page_no " + std::to_string(page_no));
+    }
+    std::string path = GetFileName(fd); //文件未打开时抛出FileNotOpenError
+
+    std::scoped_lock lock{fsm_latch_};
+    //释放的是最后分配的页面(如NewPage没有可用的帧时归还的页号)：退回自增计数，不创建.fsm文件，
+    //AllocatePages在文件末尾分配的连续页面仍然从这里开始
+    page_id_t next_page_no = page_no + 1;
+    if (fd2pageno_[fd].compare_exchange_strong(next_page_no, page_no)) {
+        return;
+    }
+    FreeSpaceMap &fsm = fsm_[fd];
+    if (fsm.fd == -1) { //第一次释放页面时才创建.fsm文件
+        fsm.fd = open((path + FSM_FILE_SUFFIX).c_str(), O_CREAT | O_RDWR, 0777);
+        if (fsm.fd == -1) {
+            throw UnixError();
+        }
+    }
+    if (!is_free(fsm, page_no)) {
+        set_free(fsm, page_no, true);
+    }
+}
+
+void DiskManager::reserve_extent(int fd, page_id_t page_no) {
+    if (DISK_EXTENT_PAGES <= 0 || page_no < fd2reserved_[fd]) {
+        return;
+    }
+    std::scoped_lock lock{extent_latch_};
+    page_id_t reserved = fd2reserved_[fd];
+    if (page_no < reserved) {
+        return; //其他线程已经预留
+    }
+    //小文件每次预留DISK_EXTENT_PAGES页，大文件按已预留大小的1/8增长，减少fallocate次数和文件碎片
+    page_id_t extent = std::clamp(reserved / 8, DISK_EXTENT_PAGES, DISK_MAX_EXTENT_PAGES);
+    page_id_t end = page_no + extent;
+    fallocate(fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(reserved) * PAGE_SIZE,
+              static_cast<off_t>(end - reserved) * PAGE_SIZE); //失败时退化为写入时逐页分配
+    fd2reserved_[fd] = end;
+}
+
+int DiskManager::GetFreePageCount(int fd) {
+    std::scoped_lock lock{fsm_latch_};
+    auto it = fsm_.find(fd);
+    return it == fsm_.end() ? 0 : it->second.num_free;
+}
+
+void DiskManager::set_free(FreeSpaceMap &fsm, page_id_t page_no, bool free) {
+    size_t byte = page_no / 8;
+    if (byte >= fsm.bits.size()) {
+        fsm.bits.resize(byte + 1, 0);
+    }
+    uint8_t mask = static_cast<uint8_t>(1 << (page_no % 8));
+    if (free) {
+        fsm.bits[byte] |= mask;
+        fsm.num_free++;
+        fsm.scan_hint = std::min(fsm.scan_hint, byte);
+    } else {
+        fsm.bits[byte] &= static_cast<uint8_t>(~mask);
+        fsm.num_free--;
+    }
+    if (pwrite(fsm.fd, &fsm.bits[byte], 1, static_cast<off_t>(byte)) != 1) {
+        throw UnixError();
+    }
+}
+
+void DiskManager::load_fsm(int fd, const std::string &path) {
+    std::string fsm_path = path + FSM_FILE_SUFFIX;
+    if (!is_file(fsm_path)) {
+        return;
+    }
+    FreeSpaceMap fsm;
+    fsm.fd = open(fsm_path.c_str(), O_RDWR);
+    if (fsm.fd == -1) {
+        throw UnixError();
+    }
+    fsm.bits.resize(GetFileSize(fsm_path));
+    if (pread(fsm.fd, fsm.bits.data(), fsm.bits.size(), 0) != static_cast<ssize_t>(fsm.bits.size())) {
+        close(fsm.fd);
+        throw UnixError();
+    }
+    for (uint8_t byte : fsm.bits) {
+        fsm.num_free += __builtin_popcount(byte);
+    }
+    std::scoped_lock lock{fsm_latch_};
+    fsm_[fd] = std::move(fsm);
+}
+
+bool DiskManager::is_dir(const std::string &path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+void DiskManager::create_dir(const std::string &path) {
+    // Create a subdirectory
+    std::string cmd = "mkdir " + path;
+    if (system(cmd.c_str()) < 0) {  // 创建一个名为path的目录
+        throw UnixError();
+    }
+}
+
+void DiskManager::destroy_dir(const std::string &path) {
+    std::string cmd = "rm -r " + path;
+    if (system(cmd.c_str()) < 0) {
+        throw UnixError();
+    }
+}
+
+/**
+ * @brief 用于判断指定路径文件是否存在 
+ */
+bool DiskManager::is_file(const std::string &path) {
+    // Todo:
+    // 用struct stat获取文件信息
+    struct stat statbuf;
+    int ret = stat(path.c_str(), &statbuf);
+    if(ret == 0){
+        //perror("comes form is_file : stat");
+        return S_ISREG(statbuf.st_mode);
+    }
+    //判断是否为常规文件
+    return false;
+}
+
+/**
+ * @brief 用于创建指定路径文件
+ */
+void DiskManager::create_file(const std::string &path) {
+    // Todo:
+    // 调用open()函数，使用O_CREAT模式
+    // 注意不能重复创建相同文件
+    //文件已经存在
+    if(is_file(path)) throw FileExistsError(path);
+
+    //使用open()创建文件
+    int fd = open(path.c_str(), O_CREAT, 0777);
+    if(fd == -1){
+        //perror("open");
+        throw UnixError();
+    }
+    //关闭文件
+    close(fd);
+
+}
+
+/**
+ * @brief 用于删除指定路径文件 
+ */
+void DiskManager::destroy_file(const std::string &path) {
+    // Todo:
+    // 调用unlink()函数
+    // 注意不能删除未关闭的文件
+    //文件在打开文件列表
+    std::scoped_lock lock{file_latch_};
+    if(path2fd_.find(path) != path2fd_.end()) 
+        throw UnixError();
+
+    //文件不存在
+    if(is_file(path) == false) 
+        throw FileNotFoundError(path);
+
+    if(unlink(path.c_str()) == -1){
+        //perror("unlink");
+        throw UnixError();
+    }
+    //一并删除空闲页映射
+    std::string fsm_path = path + FSM_FILE_SUFFIX;
+    if(is_file(fsm_path) && unlink(fsm_path.c_str()) == -1){
+        throw UnixError();
+    }
+
+}
+
+/**
+ * @brief 用于打开指定路径文件
+ */
+int DiskManager::open_file(const std::string &path) {
+    // Todo:
+    // 调用open()函数，使用O_RDWR模式
+    // 注意不能重复打开相同文件，并且需要更新文件打开列表
+    //文件在打开文件列表
+    std::scoped_lock lock{file_latch_};
+    if(path2fd_.count(path)){
+        //cerr << "file not close" << endl;
+        throw UnixError();
+    }
+
+    //文件不存在
+    if(is_file(path) == false){
+        //cerr << "comes form open_file : file not exists" << endl;
+        throw FileNotFoundError(path);
+        //return -1;
+    }
+
+    bool direct = direct_io_ && path != LOG_FILE_NAME; //日志按字节追加写，不使用直接I/O
+    int fd = open(path.c_str(), O_RDWR | (direct ? O_DIRECT : 0), 0777);
+    if(fd == -1 && direct && errno == EINVAL){
+        direct = false; //文件系统不支持O_DIRECT，退回缓冲I/O
+        fd = open(path.c_str(), O_RDWR, 0777);
+    }
+    if(fd == -1){
+        //perror("open");
+        throw UnixError();
+    }
+    fd2direct_[fd] = direct;
+    fd2checksum_[fd] = false;
+    try {
+        load_fsm(fd, path);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    //已经分配了块的部分(包括以前预留在文件末尾之后的extent)都视为已预留
+    struct stat st;
+    if(fstat(fd, &st) == 0){
+        off_t physical = std::max<off_t>(st.st_size, static_cast<off_t>(st.st_blocks) * 512);
+        fd2reserved_[fd] = static_cast<page_id_t>(physical / PAGE_SIZE);
+    }else{
+        fd2reserved_[fd] = 0;
+    }
+    path2fd_.insert(make_pair(path, fd));
+    fd2path_.insert(make_pair(fd,path));
+    return fd;
+}
+
+/**
+ * @brief 用于关闭指定路径文件
+ */
+void DiskManager::close_file(int fd) {
+    // Todo:
+    // 调用close()函数
+    // 注意不能关闭未打开的文件，并且需要更新文件打开列表
+    //文件在打开文件列表
+    std::scoped_lock lock{file_latch_};
+    if(!fd2path_.count(fd)){
+        //cerr << "file not close" << endl;
+        throw FileNotOpenError(fd);
+    }
+    //把文件从打开列表中删除
+    path2fd_.erase(fd2path_[fd]);
+    fd2path_.erase(fd);
+    close(fd);
+    {
+        std::scoped_lock fsm_lock{fsm_latch_};
+        auto it = fsm_.find(fd);
+        if (it != fsm_.end()) {
+            if (it->second.fd != -1) {
+                close(it->second.fd);
+            }
+            fsm_.erase(it);
+        }
+    }
+
+}
+
+int DiskManager::GetFileSize(const std::string &file_name) {
+    struct stat stat_buf;
+    int rc = stat(file_name.c_str(), &stat_buf);
+    return rc == 0 ? stat_buf.st_size : -1;
+}
+
+std::string DiskManager::GetFileName(int fd) {
+    std::scoped_lock lock{file_latch_};
+    if (!fd2path_.count(fd)) {
+        throw FileNotOpenError(fd);
+    }
+    return fd2path_[fd];
+}
+
+int DiskManager::GetFileFd(const std::string &file_name) {
+    int fd = FindOpenedFile(file_name);
+    if (fd == -1) {
+        return open_file(file_name);
+    }
+    return fd;
+}
+
+int DiskManager::FindOpenedFile(const std::string &file_name) {
+    std::scoped_lock lock{file_latch_};
+    auto it = path2fd_.find(file_name);
+    return it == path2fd_.end() ? -1 : it->second;
+}
+
+bool DiskManager::ReadLog(char *log_data, int size, int offset, int prev_log_end) {
+    // read log file from the previous end
+    if (log_fd_ == -1) {
+        log_fd_ = open_file(LOG_FILE_NAME);
+    }
+    offset += prev_log_end;
+    int file_size = GetFileSize(LOG_FILE_NAME);
+    if (offset >= file_size) {
+        return false;
+    }
+
+    size = std::min(size, file_size - offset);
+    ssize_t bytes_read = pread(log_fd_, log_data, size, offset);
+    if (bytes_read != size) {
+        throw UnixError();
+    }
+    return true;
+}
+
+void DiskManager::WriteLog(char *log_data, int size) {
+    if (log_fd_ == -1) {
+        log_fd_ = open_file(LOG_FILE_NAME);
+    }
+
+    // write from the file_end
+    lseek(log_fd_, 0, SEEK_END);
+    ssize_t bytes_write = write(log_fd_, log_data, size);
+    if (bytes_write != size) {
+        throw UnixError();
+    }
+}
@@ -0,0 +1,274 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// disk_manager.h
+//
+// Identification: src/storage/disk_manager.h
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <fcntl.h>     // for open/close
+#include <sys/stat.h>  // for S_ISREG
+#include <sys/uio.h>   // for preadv/pwritev
+#include <unistd.h>    // for open/close
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "errors.h"  // for throw Exception
+#include "storage/io_engine.h"
+
+/**
+ * @brief 批量页面I/O中的单个请求，描述(fd, page_no)对应页面与内存缓冲区之间的一次整页传输
+ */
+struct PageIORequest {
+    int fd;             // 页面所在文件的文件描述符
+    page_id_t page_no;  // 页面编号
+    char *buf;          // 长度为PAGE_SIZE的内存缓冲区
+};
+
+/**
+ * @brief DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading
+ * and writing of pages to and from disk, providing a logical file layer within the context of a database management
+ * system.
+ */
+class DiskManager {
+   public:
+    /**
+     * @param direct_io 表文件和索引文件是否以O_DIRECT打开：绕过操作系统页缓存，页面只在缓冲池中缓存一份，
+     * 内存预算可以全部分给缓冲池。缓冲池的帧在FrameArena中按页对齐，可以直接读写；文件头等不对齐的读写经过对齐的中转缓冲区。
+     * 文件系统不支持O_DIRECT时(如tmpfs)该文件退回缓冲I/O；日志文件总是使用缓冲I/O
+     */
+    explicit DiskManager(bool direct_io = DISK_DIRECT_IO);
+
+    ~DiskManager() = default;
+
+    /**
+     * @brief 将buffer中的页面数据写回diskFile中
+     */
+    void write_page(int fd, page_id_t page_no, const char *offset, int num_bytes);
+
+    /**
+     * @brief 读取指定编号的页面部分字节到buffer中
+     *
+     * @param fd 页面所在文件开启后的文件描述符
+     * @param page_no 指定页面编号
+     * @param offset 读取的内容写入buffer
+     * @param num_bytes 读取的字节数
+     */
+    void read_page(int fd, page_id_t page_no, char *offset, int num_bytes);
+
+    /**
+     * @brief 批量读取整页，同一文件中页号连续的请求合并为一次preadv
+     *
+     * @param requests 待读取的页面列表，顺序任意
+     */
+    void read_pages(std::vector<PageIORequest> requests);
+
+    /**
+     * @brief 批量写回整页，同一文件中页号连续的请求合并为一次pwritev
+     *
+     * @param requests 待写回的页面列表，顺序任意
+     */
+    void write_pages(std::vector<PageIORequest> requests);
+
+    /**
+     * @brief 把文件已写入的数据持久化到磁盘(fdatasync)
+     */
+    void sync_file(int fd);
+
+    /**
+     * @brief 异步读取指定页面的前num_bytes字节到buffer中，读取完成后返回的future就绪
+     * @note 在future就绪之前，offset指向的buffer必须保持有效
+     */
+    std::future<void> submit_read(int fd, page_id_t page_no, char *offset, int num_bytes);
+
+    /**
+     * @brief 异步将buffer中的num_bytes字节写回指定页面，写入完成后返回的future就绪
+     * @note 在future就绪之前，offset指向的buffer不能被修改
+     */
+    std::future<void> submit_write(int fd, page_id_t page_no, const char *offset, int num_bytes);
+
+    /**
+     * @brief Allocate a page on disk.
+     * 优先复用文件空闲页映射中被释放的页面(紧随上一次分配的页面优先，其次是页号最小的)，没有空闲页时在文件末尾分配
+     * @return the page_no of the allocated page
+     */
+    page_id_t AllocatePage(int fd);
+
+    /**
+     * @brief 在文件末尾分配num_pages个页号连续的页面，不复用空闲页映射中的页面，用于批量追加
+     * @return 第一个页面的page_no
+     */
+    page_id_t AllocatePages(int fd, int num_pages);
+
+    /**
+     * @brief Deallocate a page on disk. 把页面记入文件的空闲页映射，之后可以被AllocatePage重新分配；
+     * 释放的是文件末尾最后分配的页面时只把自增分配的页号退回一页，不记入空闲页映射
+     * @param fd 页面所在文件开启后的文件描述符
+     * @param page_no 要释放的页面编号
+     * @note 一般通过BufferPoolManager::DeletePage释放页面；页面还被短暂固定(如乐观读者)时也可以直接释放，
+     * BufferPoolManager::NewPage重新分配该页号时会先丢弃缓冲池中的旧内容
+     */
+    void DeallocatePage(int fd, page_id_t page_no);
+
+    /** @return 文件的空闲页映射中等待重新分配的页数 */
+    int GetFreePageCount(int fd);
+
+    // 目录操作
+    bool is_dir(const std::string &path);
+
+    void create_dir(const std::string &path);
+
+    void destroy_dir(const std::string &path);
+
+    // 文件操作
+    bool is_file(const std::string &path);
+
+    void create_file(const std::string &path);
+
+    void destroy_file(const std::string &path);
+
+    int open_file(const std::string &path);
+
+    void close_file(int fd);
+
+    int GetFileSize(const std::string &file_name);
+
+    std::string GetFileName(int fd);
+
+    int GetFileFd(const std::string &file_name);
+
+    /** @return 文件已经打开时返回其fd，否则返回-1(不打开文件) */
+    int FindOpenedFile(const std::string &file_name);
+
+    // LOG操作
+    bool ReadLog(char *log_data, int size, int offset, int prev_log_end);
+
+    void WriteLog(char *log_data, int size);
+
+    void SetLogFd(int log_fd) { log_fd_ = log_fd; }
+
+    int GetLogFd() { return log_fd_; }
+
+    // 在fd对应文件中，从start_page_no开始分配page_no
+    void set_fd2pageno(int fd, int start_page_no) { fd2pageno_[fd] = start_page_no; }
+
+    page_id_t get_fd2pageno(int fd) { return fd2pageno_[fd]; }
+
+    /** @return 文件是否以O_DIRECT打开 */
+    bool is_direct_io(int fd) { return fd2direct_[fd]; }
+
+    /** @return 文件已经在磁盘上预留空间的页数(物理大小)，不小于文件长度(逻辑大小)对应的页数 */
+    page_id_t get_fd2reserved(int fd) { return fd2reserved_[fd]; }
+
+    /**
+     * @brief 设置文件的页面是否带校验和：缓冲池写回页面时在Page::OFFSET_CHECKSUM处填入CRC32C，读入时校验
+     * @note 只有页面头部从Page::OFFSET_PAGE_HDR_CHECKSUM开始、留出了校验和字段的文件才能打开，
+     * 由记录文件按文件头中的page_checksum设置；打开文件时默认关闭
+     */
+    void set_page_checksum(int fd, bool enabled) { fd2checksum_[fd] = enabled; }
+
+    bool has_page_checksum(int fd) { return fd2checksum_[fd]; }
+
+    static constexpr int MAX_FD = 8192;
+
+    static constexpr const char *FSM_FILE_SUFFIX = ".fsm";  // 空闲页映射文件名的后缀
+
+   private:
+    /**
+     * @brief 文件的空闲页映射(free space map)：每页一位，置1表示页面已被释放、可以重新分配
+     * 持久化在数据文件旁的"<文件名>.fsm"中，不占用数据文件的页号，记录层和索引层的页面布局不受影响；
+     * 每次修改都立即写穿对应的字节，已分配出去的页面不会在重启之后被再次分配
+     */
+    struct FreeSpaceMap {
+        int fd = -1;                                  // .fsm文件的fd，文件还没有释放过页面时为-1
+        std::vector<uint8_t> bits;                    // 第page_no位对应第page_no页
+        int num_free = 0;                             // 置1的位数
+        size_t scan_hint = 0;                         // bits中[0, scan_hint)字节全为0，查找空闲页从这里开始
+        page_id_t last_allocated = INVALID_PAGE_ID;  // 上一次从映射中分配的页号
+    };
+
+    static bool is_free(const FreeSpaceMap &fsm, page_id_t page_no) {
+        size_t byte = page_no / 8;
+        return byte < fsm.bits.size() && (fsm.bits[byte] >> (page_no % 8) & 1) != 0;
+    }
+
+    /** @return 缓冲区地址和长度是否满足直接I/O的对齐要求 */
+    static bool is_aligned(const void *buf, size_t num_bytes) {
+        return reinterpret_cast<uintptr_t>(buf) % DIRECT_IO_ALIGNMENT == 0 && num_bytes % DIRECT_IO_ALIGNMENT == 0;
+    }
+
+    /**
+     * @brief 直接I/O文件上不对齐的读写：经过线程私有的对齐中转缓冲区，按整页读写
+     * @note 写入不足一页时先读出整页再覆盖前num_bytes字节(读-改-写)，调用者需保证同一页面的这类写入不并发
+     */
+    void bounce_read(int fd, page_id_t page_no, char *offset, int num_bytes);
+
+    void bounce_write(int fd, page_id_t page_no, const char *offset, int num_bytes);
+
+    /**
+     * @brief 在文件末尾分配的page_no超出已预留的空间时，用fallocate再预留一个extent
+     * @note 预留时保持文件长度不变(FALLOC_FL_KEEP_SIZE)：逻辑大小仍由写入决定，读未写过的页面的行为不变；
+     * 之后写入预留范围内的页面不需要文件系统再分配块。预留失败(文件系统不支持、空间不足)不影响正确性，由写入报告错误
+     */
+    void reserve_extent(int fd, page_id_t page_no);
+
+    /**
+     * @brief 打开文件时读入它的空闲页映射；调用者持有file_latch_
+     */
+    void load_fsm(int fd, const std::string &path);
+
+    /**
+     * @brief 修改page_no在空闲页映射中的状态，并写穿到.fsm文件；调用者持有fsm_latch_
+     */
+    void set_free(FreeSpaceMap &fsm, page_id_t page_no, bool free);
+
+    /**
+     * @brief 第一次提交异步I/O时才创建I/O引擎，避免只做同步I/O的场景多出引擎线程
+     */
+    IOEngine *io_engine();
+
+    /**
+     * @brief 对requests按(fd, page_no)排序，把页号连续的一段请求交给vectored_io完成
+     */
+    void batch_io(std::vector<PageIORequest> &requests, bool is_write);
+
+    /**
+     * @brief 从page_no开始，对iov中的连续页面执行一次preadv/pwritev，处理短读写
+     */
+    void vectored_io(int fd, page_id_t page_no, struct iovec *iov, int iovcnt, bool is_write);
+
+    // 文件打开列表，用于记录文件是否被打开；file_latch_保护这两个表，缓冲池的后台线程也会查询文件名
+    std::mutex file_latch_;
+    std::unordered_map<std::string, int> path2fd_;  //<Page文件磁盘路径,Page fd>哈希表
+    std::unordered_map<int, std::string> fd2path_;  //<Page fd,Page文件磁盘路径>哈希表
+
+    std::mutex fsm_latch_;                            // 保护fsm_，锁顺序在file_latch_之后
+    std::unordered_map<int, FreeSpaceMap> fsm_;  // 已打开文件的fd -> 空闲页映射
+
+    int log_fd_ = -1;                             // log file
+    std::atomic<page_id_t> fd2pageno_[MAX_FD]{};  // 在文件fd中分配的page no个数
+    std::atomic<page_id_t> fd2reserved_[MAX_FD]{};  // 文件fd在磁盘上已预留空间的页数
+    bool direct_io_;                                // 表文件和索引文件是否使用直接I/O
+    std::atomic<bool> fd2direct_[MAX_FD]{};         // 文件fd是否以O_DIRECT打开
+    std::atomic<bool> fd2checksum_[MAX_FD]{};       // 文件fd的页面是否带校验和
+    std::mutex extent_latch_;                       // 串行化预留extent
+
+    std::unique_ptr<IOEngine> io_engine_;  // 异步I/O引擎，io_uring或线程池
+    std::once_flag io_engine_once_;
+};
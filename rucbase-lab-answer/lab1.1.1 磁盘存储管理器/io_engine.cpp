@@ -0,0 +1,280 @@
+#include "storage/io_engine.h"
+
+#include <errno.h>
+#include <linux/io_uring.h>  // for io_uring_params/sqe/cqe
+#include <poll.h>            // for poll
+#include <string.h>          // for memset
+#include <sys/eventfd.h>     // for eventfd
+#include <sys/mman.h>        // for mmap
+#include <sys/syscall.h>     // for __NR_io_uring_*
+#include <unistd.h>          // for pread/pwrite
+
+#include <algorithm>
+
+#include "errors.h"
+
+std::unique_ptr<IOEngine> IOEngine::Create(unsigned queue_depth, unsigned num_threads) {
+    try {
+        return std::make_unique<IoUringIOEngine>(queue_depth);
+    } catch (UnixError &) {
+        // 内核不支持io_uring，或者被seccomp/sysctl禁用，退化为线程池
+        return std::make_unique<ThreadPoolIOEngine>(num_threads);
+    }
+}
+
+/** -- 线程池引擎 -- */
+
+ThreadPoolIOEngine::ThreadPoolIOEngine(unsigned num_threads) {
+    for (unsigned i = 0; i < std::max(num_threads, 1u); i++) {
+        workers_.emplace_back(&ThreadPoolIOEngine::worker, this);
+    }
+}
+
+ThreadPoolIOEngine::~ThreadPoolIOEngine() {
+    {
+        std::scoped_lock lock{latch_};
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &t : workers_) {
+        t.join();
+    }
+}
+
+std::future<void> ThreadPoolIOEngine::submit_read(int fd, page_id_t page_no, char *buf, int num_bytes) {
+    return submit([=]() {
+        ssize_t read_bytes = pread(fd, buf, num_bytes, static_cast<off_t>(page_no) * PAGE_SIZE);
+        if (read_bytes != num_bytes) {
+            throw UnixError();
+        }
+    });
+}
+
+std::future<void> ThreadPoolIOEngine::submit_write(int fd, page_id_t page_no, const char *buf, int num_bytes) {
+    return submit([=]() {
+        ssize_t writen_bytes = pwrite(fd, buf, num_bytes, static_cast<off_t>(page_no) * PAGE_SIZE);
+        if (writen_bytes != num_bytes) {
+            throw UnixError();
+        }
+    });
+}
+
+std::future<void> ThreadPoolIOEngine::submit(std::function<void()> io) {
+    std::packaged_task<void()> task(std::move(io));
+    std::future<void> future = task.get_future();
+    {
+        std::scoped_lock lock{latch_};
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+    return future;
+}
+
+void ThreadPoolIOEngine::worker() {
+    while (true) {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock{latch_};
+            cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+            if (tasks_.empty()) {  // stop_且队列已清空
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();  // I/O中抛出的异常由packaged_task保存到future中
+    }
+}
+
+/** -- io_uring引擎 -- */
+
+IoUringIOEngine::IoUringIOEngine(unsigned queue_depth) : queue_depth_(queue_depth) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth, &params));
+    if (ring_fd_ < 0) {
+        throw UnixError();
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_SQ_RING);
+    cq_ring_ = single_mmap ? sq_ring_
+                           : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                  ring_fd_, IORING_OFF_CQ_RING);
+    void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                      IORING_OFF_SQES);
+    if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes == MAP_FAILED) {
+        int err = errno;
+        if (sq_ring_ != MAP_FAILED) munmap(sq_ring_, sq_ring_size_);
+        if (!single_mmap && cq_ring_ != MAP_FAILED) munmap(cq_ring_, cq_ring_size_);
+        if (sqes != MAP_FAILED) munmap(sqes, sqes_size_);
+        close(ring_fd_);
+        errno = err;
+        throw UnixError();
+    }
+    sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+    stop_fd_ = eventfd(0, EFD_CLOEXEC);
+    if (stop_fd_ < 0) {
+        int err = errno;
+        munmap(sq_ring_, sq_ring_size_);
+        if (!single_mmap) munmap(cq_ring_, cq_ring_size_);
+        munmap(sqes, sqes_size_);
+        close(ring_fd_);
+        errno = err;
+        throw UnixError();
+    }
+
+    char *sq = static_cast<char *>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    char *cq = static_cast<char *>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    reaper_ = std::thread(&IoUringIOEngine::reap, this);
+}
+
+IoUringIOEngine::~IoUringIOEngine() {
+    {
+        // 等待所有在途请求完成，再提交一个user_data为0的NOP通知收割线程退出；
+        // 析构函数不能抛出异常，NOP提交失败时改为写eventfd唤醒收割线程
+        std::unique_lock<std::mutex> lock{latch_};
+        cv_.wait(lock, [this]() { return inflight_ == 0; });
+        stop_ = true;
+        try {
+            push_sqe(IORING_OP_NOP, -1, nullptr, 0, 0);
+        } catch (UnixError &) {
+            uint64_t one = 1;
+            [[maybe_unused]] ssize_t ret = write(stop_fd_, &one, sizeof(one));
+        }
+    }
+    reaper_.join();
+    close(stop_fd_);
+    munmap(sqes_, sqes_size_);
+    if (cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd_);
+}
+
+std::future<void> IoUringIOEngine::submit_read(int fd, page_id_t page_no, char *buf, int num_bytes) {
+    return submit(IORING_OP_READV, fd, page_no, buf, num_bytes);
+}
+
+std::future<void> IoUringIOEngine::submit_write(int fd, page_id_t page_no, const char *buf, int num_bytes) {
+    return submit(IORING_OP_WRITEV, fd, page_no, const_cast<char *>(buf), num_bytes);
+}
+
+std::future<void> IoUringIOEngine::submit(uint8_t opcode, int fd, page_id_t page_no, char *buf, int num_bytes) {
+    auto *req = new Request;
+    req->iov.iov_base = buf;
+    req->iov.iov_len = num_bytes;
+    req->expected = num_bytes;
+    std::future<void> future = req->promise.get_future();
+
+    std::unique_lock<std::mutex> lock{latch_};
+    cv_.wait(lock, [this]() { return inflight_ < queue_depth_; });  // 保证CQ不会溢出
+    try {
+        push_sqe(opcode, fd, &req->iov, static_cast<off_t>(page_no) * PAGE_SIZE, reinterpret_cast<uint64_t>(req));
+    } catch (UnixError &) {
+        delete req;
+        throw;
+    }
+    inflight_++;
+    return future;
+}
+
+/**
+ * @brief 填写一个SQE并立即提交，调用者需持有latch_
+ * @note 非SQPOLL模式下io_uring_enter会同步消费提交的SQE，因此SQ环中最多只有一个未消费的SQE
+ */
+void IoUringIOEngine::push_sqe(uint8_t opcode, int fd, const struct iovec *iov, off_t offset, uint64_t user_data) {
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    struct io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(iov);
+    sqe->len = iov == nullptr ? 0 : 1;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+    while (true) {
+        long ret = syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0);
+        if (ret >= 1 || __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) != tail) {
+            return;  // SQE已被内核消费，请求在途
+        }
+        if (ret < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY)) {
+            continue;
+        }
+        if (ret == 0) {
+            errno = EIO;  // 没有报错也没有消费SQE，errno是之前留下的值
+        }
+        // 撤回未被消费的SQE：调用者会释放请求，留在SQ环中的SQE会被下一次io_uring_enter提交，收割时访问已释放的请求
+        int error = errno;
+        __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+        errno = error;
+        throw UnixError();
+    }
+}
+
+/**
+ * @brief 收割线程：等待CQE，根据res完成或失败对应请求的promise
+ * @note 用poll同时等待ring fd(有CQE时可读)和stop_fd_，CQ环为空且stop_已被设置时退出
+ */
+void IoUringIOEngine::reap() {
+    while (true) {
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            if (stop_) {
+                return;  // 析构函数已经等到没有在途请求
+            }
+            struct pollfd fds[2] = {{ring_fd_, POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+            poll(fds, 2, -1);
+            continue;
+        }
+
+        unsigned completed = 0;
+        for (; head != tail; head++) {
+            struct io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+            if (cqe->user_data == 0) {
+                continue;  // 析构时提交的NOP
+            }
+            auto *req = reinterpret_cast<Request *>(cqe->user_data);
+            if (cqe->res == req->expected) {
+                req->promise.set_value();
+            } else {
+                errno = cqe->res < 0 ? -cqe->res : EIO;  // 短读写(如读到文件末尾)按EIO处理
+                req->promise.set_exception(std::make_exception_ptr(UnixError()));
+            }
+            delete req;
+            completed++;
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+        if (completed > 0) {
+            {
+                std::scoped_lock lock{latch_};
+                inflight_ -= completed;
+            }
+            cv_.notify_all();
+        }
+    }
+}
@@ -0,0 +1,145 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// io_engine.h
+//
+// Identification: src/storage/io_engine.h
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/types.h>  // for off_t
+#include <sys/uio.h>    // for iovec
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/config.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/**
+ * @brief 异步页面I/O引擎：提交读写请求后立即返回future，I/O完成时future就绪，出错时future中携带UnixError
+ * @note 优先使用io_uring，内核不支持(或被禁用)时退化为线程池+pread/pwrite
+ */
+class IOEngine {
+   public:
+    virtual ~IOEngine() = default;
+
+    /**
+     * @brief 异步读取(fd, page_no)对应页面的前num_bytes字节到buf中
+     * @note 在future就绪之前，buf必须保持有效
+     */
+    virtual std::future<void> submit_read(int fd, page_id_t page_no, char *buf, int num_bytes) = 0;
+
+    /**
+     * @brief 异步把buf中的num_bytes字节写入(fd, page_no)对应页面
+     * @note 在future就绪之前，buf必须保持有效且不能被修改
+     */
+    virtual std::future<void> submit_write(int fd, page_id_t page_no, const char *buf, int num_bytes) = 0;
+
+    /** @return 引擎名称，"io_uring" 或 "thread_pool" */
+    virtual const char *name() const = 0;
+
+    /**
+     * @brief 创建I/O引擎，io_uring初始化失败时返回线程池引擎
+     * @param queue_depth 允许同时在途的最大请求数
+     * @param num_threads 线程池引擎的工作线程数
+     */
+    static std::unique_ptr<IOEngine> Create(unsigned queue_depth, unsigned num_threads);
+};
+
+/**
+ * @brief 线程池实现的I/O引擎，每个工作线程同步地执行pread/pwrite
+ */
+class ThreadPoolIOEngine : public IOEngine {
+   public:
+    explicit ThreadPoolIOEngine(unsigned num_threads);
+
+    ~ThreadPoolIOEngine() override;
+
+    std::future<void> submit_read(int fd, page_id_t page_no, char *buf, int num_bytes) override;
+
+    std::future<void> submit_write(int fd, page_id_t page_no, const char *buf, int num_bytes) override;
+
+    const char *name() const override { return "thread_pool"; }
+
+   private:
+    std::future<void> submit(std::function<void()> io);
+
+    void worker();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::packaged_task<void()>> tasks_;  // 等待工作线程执行的I/O任务
+    std::mutex latch_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+};
+
+/**
+ * @brief 直接基于io_uring系统调用实现的I/O引擎(不依赖liburing)
+ * 提交线程在latch_保护下填写SQE并调用io_uring_enter，独立的收割线程等待CQE并完成对应的promise
+ */
+class IoUringIOEngine : public IOEngine {
+   public:
+    /**
+     * @brief 初始化io_uring，失败时抛出UnixError，由IOEngine::Create退化为线程池
+     */
+    explicit IoUringIOEngine(unsigned queue_depth);
+
+    ~IoUringIOEngine() override;
+
+    std::future<void> submit_read(int fd, page_id_t page_no, char *buf, int num_bytes) override;
+
+    std::future<void> submit_write(int fd, page_id_t page_no, const char *buf, int num_bytes) override;
+
+    const char *name() const override { return "io_uring"; }
+
+   private:
+    // 一个在途请求，地址作为SQE的user_data，收割线程据此找回promise
+    struct Request {
+        std::promise<void> promise;
+        struct iovec iov;
+        int expected;  // 期望传输的字节数，短读写视为错误
+    };
+
+    std::future<void> submit(uint8_t opcode, int fd, page_id_t page_no, char *buf, int num_bytes);
+
+    void push_sqe(uint8_t opcode, int fd, const struct iovec *iov, off_t offset, uint64_t user_data);
+
+    void reap();
+
+    int ring_fd_ = -1;
+    unsigned queue_depth_;
+
+    // mmap得到的SQ/CQ环以及SQE数组
+    void *sq_ring_ = nullptr;
+    void *cq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    struct io_uring_sqe *sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned *sq_head_, *sq_tail_, *sq_mask_, *sq_array_;
+    unsigned *cq_head_, *cq_tail_, *cq_mask_;
+    struct io_uring_cqe *cqes_;
+
+    std::mutex latch_;               // 保护SQ环和inflight_
+    std::condition_variable cv_;     // 在途请求达到queue_depth_时，提交者在此等待
+    unsigned inflight_ = 0;          // 已提交尚未收割的请求数
+    std::atomic<bool> stop_{false};
+    int stop_fd_ = -1;               // eventfd，NOP提交失败时用它唤醒收割线程退出
+    std::thread reaper_;
+};
@@ -0,0 +1,58 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_replacer.h
+//
+// Identification: src/include/buffer/clock_replacer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+#include "replacer/replacer.h"
+
+/**
+ * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used
+ * policy.
+ * 无锁实现：每个帧的状态是一个原子字节，Pin/Unpin只对该字节做一次原子操作，可淘汰帧数由原子计数器维护；
+ * Victim通过原子时钟指针扫描，最多扫描两圈，多个线程可以同时扫描
+ */
+class ClockReplacer : public Replacer {
+   public:
+    // EMPTY:     This frame not storage page or pinned (is using by some thread,can not be victim)
+    // ACCESSED:  This frame is used by some thread not so long ago
+    // UNTOUCHED: This frame can be victim
+    enum class Status : uint8_t { UNTOUCHED, ACCESSED, EMPTY_OR_PINNED };
+    /**
+     * Create a new ClockReplacer.
+     * @param num_pages the maximum number of pages the ClockReplacer will be required to store
+     */
+    explicit ClockReplacer(size_t num_pages);
+
+    /**
+     * Destroys the ClockReplacer.
+     */
+    ~ClockReplacer() override;
+
+    bool Victim(frame_id_t *frame_id) override;
+
+    void Pin(frame_id_t frame_id) override;
+
+    void Unpin(frame_id_t frame_id) override;
+
+    size_t Size() override;
+
+   private:
+    std::unique_ptr<std::atomic<Status>[]> circular_;
+    std::atomic<size_t> hand_{0};  // initial hand_ value = 0, the scan starter; 对capacity_取模得到指向的帧
+    std::atomic<int64_t> size_{0};  // 可淘汰帧数，并发Pin/Unpin时可能短暂为负
+    size_t capacity_;
+};
\ No newline at end of file
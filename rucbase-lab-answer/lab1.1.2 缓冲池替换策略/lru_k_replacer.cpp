@@ -0,0 +1,80 @@
+#include "replacer/lru_k_replacer.h"
+
+#include <algorithm>
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k)
+    : k_(std::max<size_t>(k, 1)),
+      history_(num_pages * k_, 0),
+      access_count_(num_pages, 0),
+      evictable_(num_pages, false) {}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+LRUKReplacer::Key LRUKReplacer::EvictKey(frame_id_t frame_id) const {
+    size_t count = access_count_[frame_id];
+    // 访问不足k次时环形缓冲区还没有绕回，第0项就是最早的访问；否则下一个要被覆盖的位置就是倒数第k次访问
+    size_t oldest = count < k_ ? 0 : count % k_;
+    return {history_[frame_id * k_ + oldest], frame_id};
+}
+
+/**
+ * @brief 优先淘汰访问次数不足k次的帧中最早被访问的，其次淘汰backward k-distance最大的帧
+ */
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+    std::scoped_lock lock{latch_};
+    std::set<Key> &candidates = cold_.empty() ? hot_ : cold_;
+    if (candidates.empty()) {
+        return false;
+    }
+    *frame_id = candidates.begin()->second;
+    candidates.erase(candidates.begin());
+    evictable_[*frame_id] = false;  // 访问历史保留到Evicted：调用者可能因为帧已被无锁命中固定而放弃淘汰
+    return true;
+}
+
+/**
+ * @brief 帧中将放入新页面，清除访问历史
+ */
+void LRUKReplacer::Evicted(frame_id_t frame_id) {
+    std::scoped_lock lock{latch_};
+    if (frame_id < 0 || static_cast<size_t>(frame_id) >= evictable_.size()) {
+        return;
+    }
+    if (evictable_[frame_id]) {
+        (access_count_[frame_id] < k_ ? cold_ : hot_).erase(EvictKey(frame_id));
+        evictable_[frame_id] = false;
+    }
+    access_count_[frame_id] = 0;
+}
+
+/**
+ * @brief 把帧移出可淘汰集合，保留其访问历史
+ */
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+    std::scoped_lock lock{latch_};
+    if (frame_id < 0 || static_cast<size_t>(frame_id) >= evictable_.size() || !evictable_[frame_id]) {
+        return;
+    }
+    (access_count_[frame_id] < k_ ? cold_ : hot_).erase(EvictKey(frame_id));
+    evictable_[frame_id] = false;
+}
+
+/**
+ * @brief 记录一次访问并把帧加入可淘汰集合；帧已经可淘汰时什么都不做
+ */
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+    std::scoped_lock lock{latch_};
+    if (frame_id < 0 || static_cast<size_t>(frame_id) >= evictable_.size() || evictable_[frame_id]) {
+        return;
+    }
+    size_t &count = access_count_[frame_id];
+    history_[frame_id * k_ + count % k_] = ++current_timestamp_;
+    count++;
+    (count < k_ ? cold_ : hot_).insert(EvictKey(frame_id));
+    evictable_[frame_id] = true;
+}
+
+size_t LRUKReplacer::Size() {
+    std::scoped_lock lock{latch_};
+    return cold_.size() + hot_.size();
+}
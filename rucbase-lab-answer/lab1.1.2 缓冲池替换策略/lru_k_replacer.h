@@ -0,0 +1,63 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// lru_k_replacer.h
+//
+// Identification: src/replacer/lru_k_replacer.h
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "replacer/replacer.h"
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ * 帧的backward k-distance是当前时间与倒数第k次访问之间的距离；访问次数不足k次的帧距离为无穷大，优先被淘汰，
+ * 它们之间按最早一次访问淘汰。只被访问过一次的顺序扫描页面因此不会挤掉反复访问的热点页面。
+ * @note 每次Unpin记为一次访问(缓冲池在页面的pin_count降为0时调用Pin+Unpin)，帧真正被淘汰(Evicted)时才清除访问历史
+ */
+class LRUKReplacer : public Replacer {
+   public:
+    /**
+     * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+     * @param k 计算backward k-distance所用的k
+     */
+    explicit LRUKReplacer(size_t num_pages, size_t k = LRU_K);
+
+    ~LRUKReplacer() override;
+
+    bool Victim(frame_id_t *frame_id) override;
+
+    void Pin(frame_id_t frame_id) override;
+
+    void Unpin(frame_id_t frame_id) override;
+
+    void Evicted(frame_id_t frame_id) override;
+
+    size_t Size() override;
+
+   private:
+    using Key = std::pair<uint64_t, frame_id_t>;  // (淘汰依据的访问时间, frame_id)，越小越先被淘汰
+
+    /** @return 帧在cold_/hot_中的排序键：保留的最早一次访问时间(访问满k次时即倒数第k次访问) */
+    Key EvictKey(frame_id_t frame_id) const;
+
+    std::mutex latch_;
+    size_t k_;
+    uint64_t current_timestamp_{0};
+    std::vector<uint64_t> history_;       // 每个帧最近k次访问时间的环形缓冲区，第frame_id个帧占[frame_id*k, frame_id*k+k)
+    std::vector<size_t> access_count_;    // 自上次被淘汰以来的访问次数
+    std::vector<bool> evictable_;         // 帧是否在cold_或hot_中
+    std::set<Key> cold_;                  // 访问次数<k的可淘汰帧
+    std::set<Key> hot_;                   // 访问次数>=k的可淘汰帧
+};
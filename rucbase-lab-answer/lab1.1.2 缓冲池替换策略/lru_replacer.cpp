@@ -1,72 +1,86 @@
-#include "lru_replacer.h"
-
-LRUReplacer::LRUReplacer(size_t num_pages) { max_size_ = num_pages; }
-
-LRUReplacer::~LRUReplacer() = default;
-
-/**
- * @brief 使用LRU策略删除一个victim frame，这个函数能得到frame_id
- * @param[out] frame_id id of frame that was removed, nullptr if no victim was found
- * @return true if a victim frame was found, false otherwise
- */
-bool LRUReplacer::Victim(frame_id_t *frame_id) {
-    // C++17 std::scoped_lock
-    // 它能够避免死锁发生，其构造函数能够自动进行上锁操作，析构函数会对互斥量进行解锁操作，保证线程安全。
-    std::scoped_lock lock{latch_};
-
-    // Todo:
-    //  利用lru_replacer中的LRUlist_,LRUHash_实现LRU策略
-    //  选择合适的frame指定为淘汰页面,赋值给*frame_id
-
-    if(LRUlist_.size() == 0){ //表内无元素
-        frame_id = nullptr;
-        return false;
-    }
-    *frame_id = LRUlist_.front(); //表头帧为淘汰帧
-    LRUlist_.pop_front(); //删除
-    LRUhash_.erase(*frame_id); //删除映射
-    return true;
-
-}
-
-/**
- * @brief 固定一个frame, 表明它不应该成为victim（即在replacer中移除该frame_id）
- * @param frame_id the id of the frame to pin
- */
-void LRUReplacer::Pin(frame_id_t frame_id) {
-    std::scoped_lock lock{latch_};
-    // Todo:
-    // 固定指定id的frame
-    // 在数据结构中移除该frame
-    for(auto it = LRUlist_.begin(); it != LRUlist_.end(); it ++){
-        if(*it == frame_id){
-            LRUlist_.erase(it); //删除被固定的frame
-            break;
-        }
-    }
-    LRUhash_.erase(frame_id); //删除映射
-}
-
-/**
- * 取消固定一个frame, 表明它可以成为victim（即将该frame_id添加到replacer）
- * @param frame_id the id of the frame to unpin
- */
-void LRUReplacer::Unpin(frame_id_t frame_id) {
-    // Todo:
-    //  支持并发锁
-    //  选择一个frame取消固定
-    if(LRUlist_.size() + 1 > max_size_ || LRUhash_.size() + 1 > max_size_){
-        perror("overflow");
-        return ;
-    }
-    LRUlist_.push_back(frame_id); //插入到表尾
-    LRUhash_.insert(std::make_pair(frame_id, --LRUlist_.end())); //建立映射
-}
-
-/** @return replacer中能够victim的数量 */
-size_t LRUReplacer::Size() {
-    // Todo:
-    // 改写return size
-    
-    return max_size_ - std::max(LRUlist_.size(), LRUhash_.size());
-}
+#include "lru_replacer.h"
+
+LRUReplacer::LRUReplacer(size_t num_pages) {
+    max_size_ = num_pages;
+    // 哨兵节点自成环，表示空链表
+    nodes_.assign(num_pages + 1, Node{INVALID_FRAME_ID, INVALID_FRAME_ID, false});
+    frame_id_t head = static_cast<frame_id_t>(max_size_);
+    nodes_[head].prev = nodes_[head].next = head;
+}
+
+LRUReplacer::~LRUReplacer() = default;
+
+/**
+ * @brief 使用LRU策略删除一个victim frame，这个函数能得到frame_id
+ * @param[out] frame_id id of frame that was removed, nullptr if no victim was found
+ * @return true if a victim frame was found, false otherwise
+ */
+bool LRUReplacer::Victim(frame_id_t *frame_id) {
+    // C++17 std::scoped_lock
+    // 它能够避免死锁发生，其构造函数能够自动进行上锁操作，析构函数会对互斥量进行解锁操作，保证线程安全。
+    std::scoped_lock lock{latch_};
+
+    // Todo:
+    //  利用lru_replacer中的nodes_实现LRU策略
+    //  选择合适的frame指定为淘汰页面,赋值给*frame_id
+
+    if(size_ == 0){ //表内无元素
+        return false;
+    }
+    *frame_id = nodes_[max_size_].next; //表头帧为淘汰帧
+    Remove(*frame_id); //删除
+    return true;
+
+}
+
+void LRUReplacer::Remove(frame_id_t frame_id) {
+    Node &node = nodes_[frame_id];
+    nodes_[node.prev].next = node.next;
+    nodes_[node.next].prev = node.prev;
+    node.prev = node.next = INVALID_FRAME_ID;
+    node.in_list = false;
+    size_--;
+}
+
+/**
+ * @brief 固定一个frame, 表明它不应该成为victim（即在replacer中移除该frame_id）
+ * @param frame_id the id of the frame to pin
+ */
+void LRUReplacer::Pin(frame_id_t frame_id) {
+    std::scoped_lock lock{latch_};
+    // Todo:
+    // 固定指定id的frame
+    // 在数据结构中移除该frame
+    if(frame_id >= 0 && static_cast<size_t>(frame_id) < max_size_ && nodes_[frame_id].in_list){
+        Remove(frame_id); //删除被固定的frame
+    }
+}
+
+/**
+ * 取消固定一个frame, 表明它可以成为victim（即将该frame_id添加到replacer）
+ * @param frame_id the id of the frame to unpin
+ */
+void LRUReplacer::Unpin(frame_id_t frame_id) {
+    // Todo:
+    //  支持并发锁
+    //  选择一个frame取消固定
+    std::scoped_lock lock{latch_};
+    if(frame_id < 0 || static_cast<size_t>(frame_id) >= max_size_) return ; //越界的帧号忽略，与Pin一致
+    Node &node = nodes_[frame_id];
+    if(node.in_list) return ; //已经在replacer中，重复unpin不改变顺序
+    frame_id_t head = static_cast<frame_id_t>(max_size_);
+    node.prev = nodes_[head].prev; //插入到表尾
+    node.next = head;
+    nodes_[node.prev].next = frame_id;
+    nodes_[head].prev = frame_id;
+    node.in_list = true;
+    size_++;
+}
+
+/** @return replacer中能够victim的数量 */
+size_t LRUReplacer::Size() {
+    // Todo:
+    // 改写return size
+    std::scoped_lock lock{latch_};
+    return size_;
+}
@@ -0,0 +1,64 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_replacer.h
+//
+// Identification: src/include/buffer/lru_replacer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT 包含std::mutex、std::scoped_lock
+#include <vector>
+
+#include "common/config.h"
+#include "replacer/replacer.h"
+
+/**
+ * LRUReplacer implements the lru replacement policy, which approximates the Least Recently Used policy.
+ */
+class LRUReplacer : public Replacer {
+   public:
+    /**
+     * Create a new LRUReplacer.
+     * @param num_pages the maximum number of pages the LRUReplacer will be required to store
+     */
+    explicit LRUReplacer(size_t num_pages);
+    // explicit关键字只能用来修饰类内部的构造函数声明，作用于单个参数的构造函数；被修饰的构造函数的类，不能发生相应的隐式类型转换。
+
+    /**
+     * Destroys the LRUReplacer.
+     */
+    ~LRUReplacer();
+
+    bool Victim(frame_id_t *frame_id);
+
+    void Pin(frame_id_t frame_id);
+
+    void Unpin(frame_id_t frame_id);
+
+    size_t Size();
+
+   private:
+    /**
+     * @brief 侵入式双向链表的节点，第frame_id个节点对应第frame_id个帧，下标max_size_为哨兵节点
+     * 链表首部(哨兵的next)是最久未被访问的帧，尾部(哨兵的prev)是最近被访问的帧
+     */
+    struct Node {
+        frame_id_t prev;
+        frame_id_t next;
+        bool in_list;  // 帧是否在链表中(可以被淘汰)
+    };
+
+    /** @brief 把帧从链表中摘下，调用者需持有latch_ */
+    void Remove(frame_id_t frame_id);
+
+    std::mutex latch_;          // 互斥锁
+    std::vector<Node> nodes_;   // 构造时一次性分配，Pin/Unpin/Victim不再申请内存
+    size_t size_{0};            // 链表中的帧数
+    size_t max_size_;           // 最大容量（与缓冲池的容量相同）
+};
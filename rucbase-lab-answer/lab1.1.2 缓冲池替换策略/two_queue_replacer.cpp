@@ -0,0 +1,77 @@
+#include "replacer/two_queue_replacer.h"
+
+#include <algorithm>
+
+TwoQueueReplacer::TwoQueueReplacer(size_t num_pages)
+    : a1_max_size_(std::max<size_t>(num_pages * TWO_QUEUE_A1_PERCENT / 100, 1)),
+      pos_(num_pages),
+      queue_(num_pages, Queue::NONE),
+      seen_(num_pages, false) {}
+
+TwoQueueReplacer::~TwoQueueReplacer() = default;
+
+/**
+ * @brief A1超过目标长度或Am为空时淘汰A1首部的帧，否则淘汰Am中最久未被访问的帧
+ */
+bool TwoQueueReplacer::Victim(frame_id_t *frame_id) {
+    std::scoped_lock lock{latch_};
+    std::list<frame_id_t> *victims;
+    if (!a1_.empty() && (a1_.size() > a1_max_size_ || am_.empty())) {
+        victims = &a1_;
+    } else if (!am_.empty()) {
+        victims = &am_;
+    } else {
+        return false;
+    }
+    *frame_id = victims->front();
+    victims->pop_front();
+    queue_[*frame_id] = Queue::NONE;  // seen_保留到Evicted：调用者可能因为帧已被无锁命中固定而放弃淘汰
+    return true;
+}
+
+/**
+ * @brief 帧中将放入新页面，重新从A1开始
+ */
+void TwoQueueReplacer::Evicted(frame_id_t frame_id) {
+    std::scoped_lock lock{latch_};
+    if (frame_id < 0 || static_cast<size_t>(frame_id) >= queue_.size()) {
+        return;
+    }
+    if (queue_[frame_id] != Queue::NONE) {
+        (queue_[frame_id] == Queue::A1 ? a1_ : am_).erase(pos_[frame_id]);
+        queue_[frame_id] = Queue::NONE;
+    }
+    seen_[frame_id] = false;
+}
+
+void TwoQueueReplacer::Pin(frame_id_t frame_id) {
+    std::scoped_lock lock{latch_};
+    if (frame_id < 0 || static_cast<size_t>(frame_id) >= queue_.size() || queue_[frame_id] == Queue::NONE) {
+        return;
+    }
+    (queue_[frame_id] == Queue::A1 ? a1_ : am_).erase(pos_[frame_id]);
+    queue_[frame_id] = Queue::NONE;
+}
+
+/**
+ * @brief 第一次访问的帧进入A1尾部，之后的访问进入Am尾部；帧已经可淘汰时什么都不做
+ */
+void TwoQueueReplacer::Unpin(frame_id_t frame_id) {
+    std::scoped_lock lock{latch_};
+    if (frame_id < 0 || static_cast<size_t>(frame_id) >= queue_.size() || queue_[frame_id] != Queue::NONE) {
+        return;
+    }
+    if (seen_[frame_id]) {
+        pos_[frame_id] = am_.insert(am_.end(), frame_id);
+        queue_[frame_id] = Queue::AM;
+    } else {
+        seen_[frame_id] = true;
+        pos_[frame_id] = a1_.insert(a1_.end(), frame_id);
+        queue_[frame_id] = Queue::A1;
+    }
+}
+
+size_t TwoQueueReplacer::Size() {
+    std::scoped_lock lock{latch_};
+    return a1_.size() + am_.size();
+}
@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// two_queue_replacer.h
+//
+// Identification: src/replacer/two_queue_replacer.h
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "replacer/replacer.h"
+
+/**
+ * TwoQueueReplacer implements a simplified 2Q replacement policy.
+ * 自帧装入页面以来只被访问过一次的帧在FIFO队列A1中，再次被访问的帧进入LRU队列Am；
+ * A1超过容量的TWO_QUEUE_A1_PERCENT%(或Am为空)时从A1淘汰，否则从Am淘汰，顺序扫描只会占用A1
+ * @note replacer只能看到frame_id，看不到page_id，因此没有记录已淘汰页面的A1out幽灵队列
+ */
+class TwoQueueReplacer : public Replacer {
+   public:
+    /**
+     * @param num_pages the maximum number of pages the TwoQueueReplacer will be required to store
+     */
+    explicit TwoQueueReplacer(size_t num_pages);
+
+    ~TwoQueueReplacer() override;
+
+    bool Victim(frame_id_t *frame_id) override;
+
+    void Pin(frame_id_t frame_id) override;
+
+    void Unpin(frame_id_t frame_id) override;
+
+    void Evicted(frame_id_t frame_id) override;
+
+    size_t Size() override;
+
+   private:
+    enum class Queue : uint8_t { NONE, A1, AM };
+
+    std::mutex latch_;
+    size_t a1_max_size_;                                // A1队列的目标长度
+    std::list<frame_id_t> a1_;                          // 只访问过一次的可淘汰帧，FIFO，首部最先淘汰
+    std::list<frame_id_t> am_;                          // 访问过多次的可淘汰帧，LRU，首部最久未被访问
+    std::vector<std::list<frame_id_t>::iterator> pos_;  // 帧在a1_或am_中的位置
+    std::vector<Queue> queue_;                          // 帧所在的队列，NONE表示被固定或为空
+    std::vector<bool> seen_;                            // 自上次被淘汰以来是否已经被访问过
+};
@@ -1,236 +1,1232 @@
-#include "buffer_pool_manager.h"
-
-/**
- * @brief 从free_list或replacer中得到可淘汰帧页的 *frame_id
- * @param frame_id 帧页id指针,返回成功找到的可替换帧id
- * @return true: 可替换帧查找成功 , false: 可替换帧查找失败
- */
-bool BufferPoolManager::FindVictimPage(frame_id_t *frame_id) {
-    // Todo:
-    // 1 使用BufferPoolManager::free_list_判断缓冲池是否已满需要淘汰页面
-    // 1.1 未满获得frame
-    // 1.2 已满使用replacer_中的方法选择淘汰页面
-
-    if(free_list_.size() == 0){ //无空闲帧，则采用页面替换算法
-        return replacer_->Victim(frame_id);
-    }else{ //有空闲帧
-        *frame_id = free_list_.back(); //分配表尾空闲帧
-        free_list_.pop_back();
-        return true;
-    }
-    return false;
-}
-
-/**
- * @brief 更新页面数据, 为脏页则需写入磁盘，更新page元数据(data, is_dirty, page_id)和page table
- *
- * @param page 写回页指针
- * @param new_page_id 写回页新page_id
- * @param new_frame_id 写回页新帧frame_id
- */
-void BufferPoolManager::UpdatePage(Page *page, PageId new_page_id, frame_id_t new_frame_id) {
-    // Todo:
-    // 1 如果是脏页，写回磁盘，并且把dirty置为false
-    // 2 更新page table
-    // 3 重置page的data，更新page id
-
-    //遍历page数组，将第一个脏页写回
-    //将该页更新为 新页--新帧
-    //写回要加锁
-
-    //std::scoped_lock lock{latch_};
-
-    //std::cout << "come from new page : " << __LINE__ << std::endl;
-
-    //frame_id_t frame_id = page_table_[page->id_];
-    if(page->is_dirty_ == true){ //如果该页 为脏页，则写回
-        page->is_dirty_ = false;
-        
-        //将写回页的数据写回磁盘
-        //Page *p = &pages_[frame_id];
-        disk_manager_->write_page(page->id_.fd, page->id_.page_no, page->data_, PAGE_SIZE); //将data写回磁盘
-    }
-    
-    //重置page的data
-    page->ResetMemory(); //将data清空
-
-    page_table_.erase(page->id_); //删除旧映射
-    page->id_ = new_page_id; //更新frame_id
-    page_table_.insert(std::make_pair(new_page_id, new_frame_id)); //更新新映射 
-}
-
-/**
- * Fetch the requested page from the buffer pool.
- * 如果页表中存在page_id（说明该page在缓冲池中），并且pin_count++。
- * 如果页表不存在page_id（说明该page在磁盘中），则找缓冲池victim page，将其替换为磁盘中读取的page，pin_count置1。
- * @param page_id id of page to be fetched
- * @return the requested page
- */
-Page *BufferPoolManager::FetchPage(PageId page_id) {
-    // Todo:
-    // 0.     lock latch
-    // 1.     Search the page table for the requested page (P).
-    // 1.1    If P exists, pin it and return it immediately.
-    // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
-    //        Note that pages are always found from the free list first.
-    // 2.     If R is dirty, write it back to the disk.
-    // 3.     Delete R from the page table and insert P.
-    // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-    
-    //首先在缓冲池中找page_id 将其pin_count++
-    //如果目标页不在缓冲池中，则在磁盘中找该页，并且放入缓冲池（不直接放入，而是替换）
-
-    std::scoped_lock lock{latch_};
-    //在pages数组中查找页面
-    if(page_table_.find(page_id) != page_table_.end()){  //找到该页
-        frame_id_t frame_id = page_table_[page_id];
-        Page* page = &pages_[frame_id];
-        replacer_->Pin(frame_id);
-        page->pin_count_ ++ ;
-        return page; //返回该页
-        
-    }
-    //没有在缓冲池中找到该页，则在磁盘中找
-    //找缓冲池victim page
-    frame_id_t victim_frame_id; 
-    if(!FindVictimPage(&victim_frame_id)) //找到可用帧
-        return nullptr; //没找到
-
-    //找到了则更新该帧
-    Page* victim_page = &pages_[victim_frame_id];
-    UpdatePage(victim_page, page_id, victim_frame_id);//更新该页
-    disk_manager_->read_page(page_id.fd, page_id.page_no, victim_page->data_, PAGE_SIZE); //在磁盘中将该页读出
-    replacer_->Unpin(victim_frame_id); //取消固定
-    victim_page->pin_count_ = 1; //置1
-    
-    return victim_page;
-}
-
-/**
- * Unpin the target page from the buffer pool. 取消固定pin_count>0的在缓冲池中的page
- * @param page_id id of page to be unpinned
- * @param is_dirty true if the page should be marked as dirty, false otherwise
- * @return false if the page pin count is <= 0 before this call, true otherwise
- */
-bool BufferPoolManager::UnpinPage(PageId page_id, bool is_dirty) {
-    // Todo:
-    // 0. lock latch
-    // 1. try to search page_id page P in page_table_
-    // 1.1 P在页表中不存在 return false
-    // 1.2 P在页表中存在 如何解除一次固定(pin_count)
-    // 2. 页面是否需要置脏
-
-    std::scoped_lock lock{latch_};
-    //std::cout << "come from unpinpage : " << (page_table_.find(page_id) != page_table_.end()) << std::endl;
-    if(page_table_.find(page_id) != page_table_.end()){  //缓冲池中有该页
-        frame_id_t frame_id = page_table_[page_id]; //获取该页所在帧
-        Page* page = &pages_[frame_id]; //获取该帧存储的页面数据
-        if(page->pin_count_ > 0){ //该页可以取消固定
-            page->pin_count_ -- ; //pin_count -- 
-            if(page->pin_count_ <= 0)
-                replacer_->Unpin(frame_id); //可以unpin
-            page->is_dirty_ = is_dirty; //标记
-        }else return false;
-    }else return false;
-    return true;
-}
-
-/**
- * Flushes the target page to disk. 将page写入磁盘；不考虑pin_count
- * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
- * @return false if the page could not be found in the page table, true otherwise
- */
-bool BufferPoolManager::FlushPage(PageId page_id) {
-    // Todo:
-    // 0. lock latch
-    // 1. 页表查找
-    // 2. 存在时如何写回磁盘
-    // 3. 写回后页面的脏位
-    // Make sure you call disk_manager_->WritePage!
-
-    std::scoped_lock lock{latch_};
-    if(page_table_.find(page_id) != page_table_.end()){ //有该页
-        frame_id_t frame_id = page_table_[page_id]; //取该页帧位
-        Page* page = &pages_[frame_id]; //取缓冲池中该页数据
-        disk_manager_->write_page(page_id.fd, page_id.page_no, page->data_, PAGE_SIZE); //将该页写回磁盘
-        page->is_dirty_ = false;  //脏位清空
-    }else return false;
-    return true;
-}
-
-/**
- * Creates a new page in the buffer pool. 相当于从磁盘中移动一个新建的空page到缓冲池某个位置
- * @param[out] page_id id of created page
- * @return nullptr if no new pages could be created, otherwise pointer to new page
- */
-Page *BufferPoolManager::NewPage(PageId *page_id) {
-    // Todo:
-    // 0.   lock latch
-    // 1.   Make sure you call disk_manager_->AllocatePage!
-    // 2.   If all the pages in the buffer pool are pinned, return nullptr.
-    // 3.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
-    // 4.   Update P's metadata, zero out memory and add P to the page table. pin_count set to 1.
-    // 5.   Set the page ID output parameter. Return a pointer to P.
-
-    std::scoped_lock lock{latch_};
-    page_id->page_no = disk_manager_->AllocatePage(page_id->fd); //分配一个page_no
-    frame_id_t frame_id = -1;
-    if(!FindVictimPage(&frame_id)) return nullptr; //获取可替换的帧
-    //std::cout << "come from new page : " << __LINE__ << std::endl;
-
-    Page* page = &pages_[frame_id]; //获取该帧页面数据
-
-    UpdatePage(page, *page_id, frame_id); //更新该页面
-
-    
-    replacer_->Pin(frame_id);//
-    page->pin_count_ = 1; //重置pin_count
-
-    return page;
-}
-
-/**
- * @brief Deletes a page from the buffer pool.
- * @param page_id id of page to be deleted
- * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
- */
-bool BufferPoolManager::DeletePage(PageId page_id) {
-    // Todo:
-    // 0.   lock latch
-    // 1.   Make sure you call disk_manager_->DeallocatePage!
-    // 2.   Search the page table for the requested page (P).
-    // 2.1  If P does not exist, return true.
-    // 2.2  If P exists, but has a non-zero pin-count, return false. Someone is using the page.
-    // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free
-    // list.
-
-    std::scoped_lock lock{latch_};
-    //DeallocatePage()
-    if(page_table_.find(page_id) != page_table_.end()){ //该页在缓冲池中
-        frame_id_t frame_id = page_table_[page_id];
-        Page* page = &pages_[frame_id]; //取页数据
-        if(page->pin_count_ != 0) return false;
-        page_table_.erase(page_id);
-        disk_manager_->DeallocatePage(page_id.page_no); //?????
-
-        free_list_.push_back(frame_id);//释放，插入到可用帧列表
-    }
-    return true;
-}
-
-/**
- * @brief Flushes all the pages in the buffer pool to disk.
- *
- * @param fd 指定的diskfile open句柄
- */
-void BufferPoolManager::FlushAllPages(int fd) {
-    // example for disk write
-    std::scoped_lock lock{latch_};
-    for (size_t i = 0; i < pool_size_; i++) {
-        Page *page = &pages_[i];
-        if (page->GetPageId().fd == fd && page->GetPageId().page_no != INVALID_PAGE_ID) {
-            disk_manager_->write_page(page->GetPageId().fd, page->GetPageId().page_no, page->GetData(), PAGE_SIZE);
-            page->is_dirty_ = false;
-        }
-    }
-}
\ No newline at end of file
+#include "buffer_pool_manager.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "recovery/log_manager.h"
+
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_shards,
+                                     const std::string &replacer_type, size_t flusher_clean_percent,
+                                     size_t max_pool_size)
+    : pool_size_(pool_size),
+      max_pool_size_(std::max(pool_size, max_pool_size)),
+      disk_manager_(disk_manager),
+      flusher_clean_percent_(flusher_clean_percent) {
+    if (num_shards == 0) {
+        num_shards = pool_size_ / BUFFER_POOL_MIN_SHARD_FRAMES;
+    }
+    num_shards_ = std::clamp<size_t>(num_shards, 1, std::min<size_t>(BUFFER_POOL_MAX_SHARDS, std::max<size_t>(pool_size_, 1)));
+    // We allocate a consecutive memory space for the buffer pool.
+    // 按max_pool_size_分配，Resize不需要移动已有的帧，无锁命中的线程看到的pages_始终有效
+    arena_ = std::make_unique<FrameArena>(max_pool_size_);
+    pages_ = new Page[max_pool_size_];
+    shards_ = new BufferPoolShard[num_shards_];
+    stats_ = std::make_unique<BufferPoolStats>(num_shards_);
+    // 每个分片的replacer只需要容纳该分片的帧
+    size_t shard_frames = (max_pool_size_ + num_shards_ - 1) / num_shards_;
+    for (size_t i = 0; i < num_shards_; i++) {
+        shards_[i].page_table_ = std::make_unique<PageTable>(shard_frames);
+        shards_[i].replacer_ = CreateReplacer(replacer_type, shard_frames);
+    }
+    // Initially, every page is in the free list of its shard.
+    for (size_t i = 0; i < max_pool_size_; ++i) {
+        pages_[i].data_ = arena_->GetFrame(i);
+        pages_[i].pin_count_ = -1;  // 空闲帧和离线帧不能被无锁地固定
+        if (i < pool_size_) {
+            shards_[i % num_shards_].free_list_.emplace_back(static_cast<frame_id_t>(i));  // static_cast转换数据类型
+        }
+    }
+    read_ahead_next_.reset(new std::atomic<page_id_t>[DiskManager::MAX_FD]);
+    for (int fd = 0; fd < DiskManager::MAX_FD; fd++) {
+        read_ahead_next_[fd].store(INVALID_PAGE_ID, std::memory_order_relaxed);
+    }
+    prefetcher_ = std::thread(&BufferPoolManager::RunPrefetcher, this);
+    if (flusher_clean_percent_ > 0) {
+        flusher_ = std::thread(&BufferPoolManager::RunFlusher, this);
+    }
+}
+
+/**
+ * @brief 按名称创建替换策略："LRU", "CLOCK", "LRU-K" 或 "2Q"，名称无效时使用LRU
+ */
+Replacer *BufferPoolManager::CreateReplacer(const std::string &replacer_type, size_t num_pages) {
+    if (replacer_type == "LRU") {
+        return new LRUReplacer(num_pages);
+    } else if (replacer_type == "CLOCK") {
+        return new ClockReplacer(num_pages);
+    } else if (replacer_type == "LRU-K") {
+        return new LRUKReplacer(num_pages, LRU_K);
+    } else if (replacer_type == "2Q") {
+        return new TwoQueueReplacer(num_pages);
+    }
+    LOG_WARN("BufferPoolManager Replacer type defined wrong, use LRU as replacer.\n");
+    return new LRUReplacer(num_pages);
+}
+
+BufferPoolManager::~BufferPoolManager() {
+    stop_warm_up_ = true;
+    if (warm_up_.joinable()) {
+        warm_up_.join();
+    }
+    if (dumper_.joinable()) {
+        {
+            std::scoped_lock lock{dumper_latch_};
+            stop_dumper_ = true;
+        }
+        dumper_cv_.notify_one();
+        dumper_.join();
+    }
+    {
+        std::scoped_lock lock{prefetch_latch_};
+        stop_prefetcher_ = true;
+    }
+    prefetch_cv_.notify_one();
+    prefetcher_.join();
+    if (flusher_.joinable()) {
+        {
+            std::scoped_lock lock{flusher_latch_};
+            stop_flusher_ = true;
+        }
+        flusher_cv_.notify_one();
+        flusher_.join();
+    }
+    for (size_t i = 0; i < num_shards_; i++) {
+        delete shards_[i].replacer_;
+    }
+    delete[] shards_;
+    delete[] pages_;
+}
+
+/**
+ * @brief 从分片的free_list或replacer中得到可淘汰帧页的 *frame_id，调用者需持有shard.latch_
+ * @param frame_id 帧页id指针,返回成功找到的可替换帧id(全局帧号)
+ * @return true: 可替换帧查找成功 , false: 可替换帧查找失败
+ */
+bool BufferPoolManager::FindVictimPage(BufferPoolShard &shard, frame_id_t *frame_id) {
+    // Todo:
+    // 1 使用BufferPoolManager::free_list_判断缓冲池是否已满需要淘汰页面
+    // 1.1 未满获得frame
+    // 1.2 已满使用replacer_中的方法选择淘汰页面
+
+    if(shard.free_list_.size() == 0){ //无空闲帧，则采用页面替换算法
+        //命中时不经过replacer，replacer中可能有已经被无锁固定的帧：把pin_count从0改为-1成功才能淘汰，否则丢弃该帧，
+        //它的pin_count再次降为0时会被重新加入replacer
+        frame_id_t local_frame_id;
+        while(shard.replacer_->Victim(&local_frame_id)){
+            *frame_id = ToGlobalFrame(shard, local_frame_id);
+            int expected = 0;
+            if(pages_[*frame_id].pin_count_.compare_exchange_strong(expected, -1)) return true;
+        }
+        return false;
+    }else{ //有空闲帧，空闲帧的pin_count已经是-1
+        *frame_id = shard.free_list_.back(); //分配表尾空闲帧
+        shard.free_list_.pop_back();
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 更新page元数据(is_dirty, page_id, pin_count)和page table，把帧标记为I/O进行中；调用者需持有shard.latch_
+ * @note 写回旧页面、读入新页面的磁盘I/O不在这里做，而是释放latch之后由FillFrame完成，避免一次磁盘I/O阻塞整个分片
+ *
+ * @param page 写回页指针
+ * @param new_page_id 写回页新page_id
+ * @param new_frame_id 写回页新帧frame_id
+ * @param[out] old_page_id 帧中原来的页面
+ * @return 原来的页面是否为脏页，需要写回磁盘
+ */
+bool BufferPoolManager::UpdatePage(BufferPoolShard &shard, Page *page, PageId new_page_id, frame_id_t new_frame_id,
+                                   PageId *old_page_id) {
+    // Todo:
+    // 1 如果是脏页，写回磁盘，并且把dirty置为false
+    // 2 更新page table
+    // 3 重置page的data，更新page id
+
+    *old_page_id = page->id_;
+    //后台写回线程正在写回旧页面的副本时也要写回：那次写回可能失败，旧页面被淘汰之后就只剩帧中这一份数据
+    bool write_back = (page->is_dirty_ || shard.flushing_.count(page->id_) > 0) && page->id_.page_no != INVALID_PAGE_ID;
+    if(write_back){ //如果该页 为脏页，则登记为正在写回，写回完成前其他线程不能从磁盘读入该页
+        shard.writing_back_.insert(page->id_);
+        stats_->Add(ShardIndex(shard), page->id_.fd, BufferPoolStats::DIRTY_WRITE_BACK);
+    }
+    if(page->id_.page_no != INVALID_PAGE_ID){
+        stats_->Add(ShardIndex(shard), page->id_.fd, BufferPoolStats::EVICTION);
+    }
+    page->is_dirty_ = false;
+
+    //帧中的旧页面与新页面一定属于同一个分片(帧只属于一个分片，分片只缓存哈希到自己的页面)
+    //此时帧的pin_count为-1，无锁命中的线程不能固定该帧，可以安全地修改id_
+    shard.page_table_->Erase(page->id_); //删除旧映射
+    page->id_ = new_page_id; //更新frame_id
+    shard.page_table_->Insert(new_page_id, new_frame_id); //更新新映射 
+    shard.replacer_->Evicted(ToLocalFrame(new_frame_id)); //帧确定换入新页面之后才清除replacer中旧页面的访问历史
+    shard.replacer_->Pin(ToLocalFrame(new_frame_id)); //新页面被固定，不能成为victim
+    page->io_in_progress_ = true; //data_在FillFrame完成之前无效
+    page->pin_count_ = 1; //最后发布pin_count，之后无锁命中的线程才能固定该帧
+    return write_back;
+}
+
+/**
+ * @brief 在不持有latch的情况下完成帧的磁盘I/O：写回旧页面，再读入(或清零)新页面，最后清除io_in_progress_并唤醒等待者
+ * @note I/O失败时撤销UpdatePage对页表的修改：旧页面没写回则恢复旧映射，否则释放该帧；然后把异常抛给调用者
+ *
+ * @param old_page_id 帧中原来的页面
+ * @param write_back 是否需要写回原来的页面
+ * @param read 是否从磁盘读入新页面，否则把data_清零(NewPage)
+ */
+void BufferPoolManager::FillFrame(BufferPoolShard &shard, Page *page, frame_id_t frame_id, const PageId &old_page_id,
+                                  bool write_back, bool read) {
+    std::exception_ptr error;
+    bool written = false;
+    try {
+        if (write_back) {
+            {  //等后台写回线程对旧页面的写回先完成，否则较旧的副本可能覆盖这次写回
+                std::unique_lock<std::mutex> lock{shard.latch_};
+                shard.io_cv_.wait(lock, [&]() { return shard.flushing_.count(old_page_id) == 0; });
+            }
+            uint64_t start = BufferPoolStats::Now();
+            SealPage(old_page_id, page->data_);
+            disk_manager_->submit_write(old_page_id.fd, old_page_id.page_no, page->data_, PAGE_SIZE).get();
+            stats_->RecordSince(ShardIndex(shard), BufferPoolStats::DISK_WRITE, start);
+            written = true;
+        }
+        if (read) {
+            uint64_t start = BufferPoolStats::Now();
+            disk_manager_->submit_read(page->id_.fd, page->id_.page_no, page->data_, PAGE_SIZE).get();
+            stats_->RecordSince(ShardIndex(shard), BufferPoolStats::DISK_READ, start);
+            VerifyPage(shard, page->id_, page->data_);  //只在读入时校验一次，之后的命中不再校验
+        } else {
+            page->ResetMemory();
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    {
+        std::scoped_lock lock{shard.latch_};
+        if (write_back) {
+            shard.writing_back_.erase(old_page_id);
+        }
+        page->io_in_progress_ = false;
+        if (error) {
+            shard.page_table_->Erase(page->id_);
+            if (write_back && !written) {  // 旧页面的数据还在帧里，恢复旧映射
+                page->id_ = old_page_id;
+                page->is_dirty_ = true;
+                shard.page_table_->Insert(old_page_id, frame_id);
+            } else {
+                page->id_.page_no = INVALID_PAGE_ID;
+            }
+            UnpinFrame(shard, frame_id);  // 释放本线程的固定，等待该页面的线程发现page_id不匹配后会重试
+        }
+    }
+    shard.io_cv_.notify_all();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * @brief 解除一次对帧的固定，pin_count降为0时，有效页面交给replacer，无效帧放回free_list；调用者需持有shard.latch_
+ */
+void BufferPoolManager::UnpinFrame(BufferPoolShard &shard, frame_id_t frame_id) {
+    Page *page = &pages_[frame_id];
+    if (--page->pin_count_ > 0) {
+        return;
+    }
+    if (page->id_.page_no == INVALID_PAGE_ID) {
+        // 无锁命中的线程可能刚刚固定了该帧，它发现page_id不匹配后会再次调用UnpinFrame
+        int expected = 0;
+        if (page->pin_count_.compare_exchange_strong(expected, -1)) {
+            ReleaseFrame(shard, frame_id);
+        }
+    } else {
+        shard.replacer_->Unpin(ToLocalFrame(frame_id));
+    }
+}
+
+/**
+ * @brief 把空闲帧放回free_list，已经下线(帧号不小于pool_size_)的帧不放回；调用者需持有shard.latch_
+ */
+void BufferPoolManager::ReleaseFrame(BufferPoolShard &shard, frame_id_t frame_id) {
+    if (static_cast<size_t>(frame_id) < pool_size_) {
+        shard.free_list_.push_back(frame_id);
+    }
+}
+
+/**
+ * @brief 无锁地固定帧：pin_count>=0时CAS加1，pin_count为-1(空闲或正在被淘汰)时失败
+ * @note 固定成功之后帧不会被淘汰，调用者需要再检查帧中的page_id是否是自己要找的页面
+ */
+bool BufferPoolManager::TryPinFrame(Page *page) {
+    int count = page->pin_count_.load();
+    while (count >= 0) {
+        if (page->pin_count_.compare_exchange_weak(count, count + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 已经固定了帧，等待帧上的I/O完成；帧中仍是page_id时返回true，否则(读入失败)解除固定并返回false
+ * @note lock必须是shard.latch_上的锁
+ */
+bool BufferPoolManager::WaitForFrame(BufferPoolShard &shard, std::unique_lock<std::mutex> &lock, frame_id_t frame_id,
+                                     const PageId &page_id) {
+    Page *page = &pages_[frame_id];
+    shard.io_cv_.wait(lock, [page]() { return !page->io_in_progress_; });
+    if (page->id_ == page_id) {
+        return true;
+    }
+    UnpinFrame(shard, frame_id);
+    return false;
+}
+
+/**
+ * @brief 等待page_id所在帧的I/O以及page_id的写回完成；lock必须是shard.latch_上的锁
+ */
+void BufferPoolManager::WaitForIO(BufferPoolShard &shard, std::unique_lock<std::mutex> &lock, const PageId &page_id) {
+    shard.io_cv_.wait(lock, [&]() {
+        if (shard.writing_back_.count(page_id) > 0 || shard.flushing_.count(page_id) > 0) {
+            return false;
+        }
+        frame_id_t frame_id;
+        return !shard.page_table_->Find(page_id, &frame_id) || !pages_[frame_id].io_in_progress_;
+    });
+}
+
+/**
+ * Fetch the requested page from the buffer pool.
+ * 如果页表中存在page_id（说明该page在缓冲池中），并且pin_count++。
+ * 如果页表不存在page_id（说明该page在磁盘中），则找缓冲池victim page，将其替换为磁盘中读取的page，pin_count置1。
+ * 读写磁盘时不持有分片的latch：帧被标记为I/O进行中，同一页面的其他FetchPage在该帧上等待，而不是阻塞整个分片
+ * @param page_id id of page to be fetched
+ * @return the requested page
+ */
+Page *BufferPoolManager::FetchPage(PageId page_id) {
+    // Todo:
+    // 0.     lock latch
+    // 1.     Search the page table for the requested page (P).
+    // 1.1    If P exists, pin it and return it immediately.
+    // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
+    //        Note that pages are always found from the free list first.
+    // 2.     If R is dirty, write it back to the disk.
+    // 3.     Delete R from the page table and insert P.
+    // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
+    
+    //首先在缓冲池中找page_id 将其pin_count++
+    //如果目标页不在缓冲池中，则在磁盘中找该页，并且放入缓冲池（不直接放入，而是替换）
+
+    uint64_t start = BufferPoolStats::Now();
+    BufferPoolShard &shard = GetShard(page_id);
+    frame_id_t frame_id;
+    std::unique_lock<std::mutex> lock{shard.latch_, std::defer_lock};
+    //无锁命中：页表无锁查找，CAS固定帧之后确认帧中确实是该页；命中的帧不从replacer中移除，淘汰时由pin_count的CAS过滤
+    if(shard.page_table_->Find(page_id, &frame_id) && TryPinFrame(&pages_[frame_id])){
+        Page* page = &pages_[frame_id];
+        if(page->id_ == page_id && !page->io_in_progress_){
+            TouchPage(page);
+            RecordHit(shard, page_id, start);
+            return page; //返回该页
+        }
+        //帧正在读入，或者查找之后帧已被替换为其他页面，持有latch处理
+        LockShard(shard, lock);
+        if(WaitForFrame(shard, lock, frame_id, page_id)){
+            TouchPage(page);
+            RecordHit(shard, page_id, start);
+            return page;
+        }
+    }else{
+        LockShard(shard, lock);
+    }
+    frame_id_t victim_frame_id;
+    while (true) {
+        //持有latch在分片的页表中查找页面，页表中的帧pin_count一定>=0
+        if(shard.page_table_->Find(page_id, &frame_id)){  //找到该页
+            Page* page = &pages_[frame_id];
+            page->pin_count_ ++ ;
+            //其他线程可能正在读入该页，先固定该帧再等待，保证帧不会被淘汰；读入失败时重新查找
+            if(WaitForFrame(shard, lock, frame_id, page_id)){
+                TouchPage(page);
+                RecordHit(shard, page_id, start);
+                return page; //返回该页
+            }
+            continue;
+        }
+        //该页刚被淘汰，正在写回(或后台写回线程正在写回它的副本)，写回完成后才能重新读入
+        if (shard.writing_back_.count(page_id) > 0 || shard.flushing_.count(page_id) > 0) {
+            shard.io_cv_.wait(lock);
+            continue;
+        }
+        //没有在缓冲池中找到该页，则在磁盘中找
+        //找缓冲池victim page
+        if(FindVictimPage(shard, &victim_frame_id)) break; //找到可用帧
+        if(shard.prefetching_ == 0) return nullptr; //没找到
+        shard.io_cv_.wait(lock); //预读线程暂时固定着一些帧，等预读完成后重新查找
+    }
+
+    //找到了则更新该帧
+    Page* victim_page = &pages_[victim_frame_id];
+    PageId old_page_id;
+    bool write_back = UpdatePage(shard, victim_page, page_id, victim_frame_id, &old_page_id);//更新该页
+    lock.unlock();
+    if(write_back) flusher_cv_.notify_one(); //请求路径上淘汰了脏页，说明干净帧不够，提前唤醒后台写回线程
+    DetectSequential(page_id); //顺序访问时预读后续页面，预读的I/O与本次读入同时进行
+    FillFrame(shard, victim_page, victim_frame_id, old_page_id, write_back, true); //写回旧页面并在磁盘中将该页读出
+    
+    TouchPage(victim_page);
+    stats_->Add(ShardIndex(shard), page_id.fd, BufferPoolStats::MISS);
+    stats_->RecordSince(ShardIndex(shard), BufferPoolStats::FETCH_MISS, start);
+    return victim_page;
+}
+
+/**
+ * Unpin the target page from the buffer pool. 取消固定pin_count>0的在缓冲池中的page
+ * @param page_id id of page to be unpinned
+ * @param is_dirty true if the page should be marked as dirty, false otherwise
+ * @return false if the page pin count is <= 0 before this call, true otherwise
+ */
+bool BufferPoolManager::UnpinPage(PageId page_id, bool is_dirty) {
+    // Todo:
+    // 0. lock latch
+    // 1. try to search page_id page P in page_table_
+    // 1.1 P在页表中不存在 return false
+    // 1.2 P在页表中存在 如何解除一次固定(pin_count)
+    // 2. 页面是否需要置脏
+
+    //调用者持有该页的固定，帧不会被淘汰，因此不需要latch：无锁查找页表，CAS减少pin_count
+    BufferPoolShard &shard = GetShard(page_id);
+    frame_id_t frame_id;
+    if(!shard.page_table_->Find(page_id, &frame_id)) return false; //缓冲池中没有该页
+    Page* page = &pages_[frame_id]; //获取该帧存储的页面数据
+    int count = page->pin_count_.load();
+    if(count <= 0 || !(page->id_ == page_id)) return false;
+    if(is_dirty) page->is_dirty_ = true; //只置脏，不能清除其他线程留下的脏标记
+    while(!page->pin_count_.compare_exchange_weak(count, count - 1)){
+        if(count <= 0) return false;
+    }
+    if(count == 1){ //pin_count降为0，重新加入replacer，并更新它在replacer中的访问顺序(命中时没有经过replacer)
+        shard.replacer_->Pin(ToLocalFrame(frame_id));
+        shard.replacer_->Unpin(ToLocalFrame(frame_id)); //可以unpin
+    }
+    return true;
+}
+
+/**
+ * Flushes the target page to disk. 将page写入磁盘；不考虑pin_count
+ * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+ * @return false if the page could not be found in the page table, true otherwise
+ */
+bool BufferPoolManager::FlushPage(PageId page_id) {
+    // Todo:
+    // 0. lock latch
+    // 1. 页表查找
+    // 2. 存在时如何写回磁盘
+    // 3. 写回后页面的脏位
+    // Make sure you call disk_manager_->WritePage!
+
+    BufferPoolShard &shard = GetShard(page_id);
+    std::unique_lock<std::mutex> lock{shard.latch_};
+    WaitForIO(shard, lock, page_id); //等待正在进行的读入或写回完成，I/O进行中的帧数据无效
+    frame_id_t frame_id;
+    if(!shard.page_table_->Find(page_id, &frame_id)) return false;
+    Page* page = &pages_[frame_id]; //取缓冲池中该页数据
+    page->pin_count_ ++ ; //固定该帧，写回期间不会被淘汰
+    shard.flushing_.insert(page_id); //登记为正在写回，其他FlushPage、DeletePage和淘汰等待本次写回完成
+    lock.unlock();
+
+    std::unique_ptr<char[]> buffer{new char[PAGE_SIZE]};
+    std::exception_ptr error;
+    try {
+        CopyPageForWrite(page, buffer.get());
+        disk_manager_->write_page(page_id.fd, page_id.page_no, buffer.get(), PAGE_SIZE); //将该页的副本写回磁盘
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    lock.lock();
+    shard.flushing_.erase(page_id);
+    if (error) page->is_dirty_ = true; //写回失败，恢复脏位
+    UnpinFrame(shard, frame_id);
+    lock.unlock();
+    shard.io_cv_.notify_all();
+    if (error) std::rethrow_exception(error);
+    return true;
+}
+
+/**
+ * @brief 持有页面读锁复制页面，在副本上填入校验和；写锁保护下的修改不会被复制一半，校验和与写回的内容一致
+ * @note 先清除脏位再复制：复制之后的修改会在解除固定时重新置脏，不会因为这次写回而丢失
+ * @param buffer 至少一个页面大小的缓冲区
+ */
+void BufferPoolManager::CopyPageForWrite(Page *page, char *buffer) {
+    page->RLatch();
+    page->is_dirty_ = false;
+    memcpy(buffer, page->data_, PAGE_SIZE);
+    page->RUnlatch();
+    SealPage(page->id_, buffer);
+}
+
+/**
+ * Creates a new page in the buffer pool. 相当于从磁盘中移动一个新建的空page到缓冲池某个位置
+ * @param[out] page_id id of created page
+ * @return nullptr if no new pages could be created, otherwise pointer to new page
+ */
+Page *BufferPoolManager::NewPage(PageId *page_id) {
+    // Todo:
+    // 0.   lock latch
+    // 1.   Make sure you call disk_manager_->AllocatePage!
+    // 2.   If all the pages in the buffer pool are pinned, return nullptr.
+    // 3.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
+    // 4.   Update P's metadata, zero out memory and add P to the page table. pin_count set to 1.
+    // 5.   Set the page ID output parameter. Return a pointer to P.
+
+    page_id->page_no = disk_manager_->AllocatePage(page_id->fd); //分配一个page_no，决定了新页面所属的分片
+    BufferPoolShard &shard = GetShard(*page_id);
+    std::unique_lock<std::mutex> lock{shard.latch_, std::defer_lock};
+    LockShard(shard, lock);
+    //页号可能是空闲页映射回收的页面，缓冲池中还可能留着它被释放之后读入的旧内容(预读、乐观读者)，先丢弃
+    WaitForIO(shard, lock, *page_id);
+    while(!DiscardPage(shard, *page_id)){
+        lock.unlock(); //乐观读者短暂固定着旧内容，等它解除固定
+        std::this_thread::yield();
+        LockShard(shard, lock);
+        WaitForIO(shard, lock, *page_id);
+    }
+    frame_id_t frame_id = -1;
+    while(!FindVictimPage(shard, &frame_id)){ //获取可替换的帧
+        if(shard.prefetching_ == 0){
+            lock.unlock();
+            disk_manager_->DeallocatePage(page_id->fd, page_id->page_no); //没有可用的帧，归还已经分配的页号
+            return nullptr;
+        }
+        shard.io_cv_.wait(lock); //预读线程暂时固定着一些帧，等预读完成后重新查找
+    }
+    //std::cout << "come from new page : " << __LINE__ << std::endl;
+
+    Page* page = &pages_[frame_id]; //获取该帧页面数据
+
+    PageId old_page_id;
+    bool write_back = UpdatePage(shard, page, *page_id, frame_id, &old_page_id); //更新该页面，pin_count置1
+    lock.unlock();
+    if(write_back) flusher_cv_.notify_one();
+    try {
+        FillFrame(shard, page, frame_id, old_page_id, write_back, false); //写回旧页面，清零新页面
+    } catch (...) {
+        //旧页面写回失败，新页面已经从页表中移除，归还页号
+        try {
+            disk_manager_->DeallocatePage(page_id->fd, page_id->page_no);
+        } catch (...) {
+            //归还失败只泄漏一个页号，向调用者报告原来的写回错误
+        }
+        throw;
+    }
+    //新页面在磁盘上还不存在(或者是回收页号上的旧内容)，置脏保证淘汰时写回，否则调用者没有修改就解除固定时，
+    //再次读入会读到文件末尾之外或者读到被释放之前的旧数据
+    page->is_dirty_ = true;
+
+    TouchPage(page);
+    return page;
+}
+
+/**
+ * @brief Deletes a page from the buffer pool.
+ * @param page_id id of page to be deleted
+ * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+ */
+bool BufferPoolManager::DeletePage(PageId page_id) {
+    // Todo:
+    // 0.   lock latch
+    // 1.   Make sure you call disk_manager_->DeallocatePage!
+    // 2.   Search the page table for the requested page (P).
+    // 2.1  If P does not exist, return true.
+    // 2.2  If P exists, but has a non-zero pin-count, return false. Someone is using the page.
+    // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free
+    // list.
+
+    BufferPoolShard &shard = GetShard(page_id);
+    std::unique_lock<std::mutex> lock{shard.latch_};
+    WaitForIO(shard, lock, page_id); //正在写回的页面要等写回完成，避免删除后又被写回磁盘
+    if(!DiscardPage(shard, page_id)) return false; //有线程正在使用该页(包括无锁命中)
+    lock.unlock();
+    //页面移出缓冲池之后才交给空闲页映射，之后它可以被NewPage重新分配
+    disk_manager_->DeallocatePage(page_id.fd, page_id.page_no);
+    return true;
+}
+
+/**
+ * @brief Flushes all the pages in the buffer pool to disk.
+ *
+ * @param fd 指定的diskfile open句柄
+ */
+void BufferPoolManager::FlushAllPages(int fd) {
+    // example for disk write
+    // 按分片编号顺序锁住所有分片，等待该分片中属于fd的帧I/O完成，之后固定该文件的所有页面并登记到flushing_，
+    // 写回期间这些帧不会被淘汰，也不会有其他写回；释放分片latch之后持有页面读锁复制页面，
+    // 每BUFFER_POOL_FLUSHER_BATCH页一批提交给异步I/O引擎，让多个写请求同时在途，再统一等待完成
+    std::vector<frame_id_t> frame_ids;
+    {
+        std::vector<std::unique_lock<std::mutex>> locks;
+        locks.reserve(num_shards_);
+        for (size_t i = 0; i < num_shards_; i++) {
+            BufferPoolShard &shard = shards_[i];
+            locks.emplace_back(shard.latch_);
+            shard.io_cv_.wait(locks.back(), [&]() {
+                for (auto &old_page_id : shard.writing_back_) {
+                    if (old_page_id.fd == fd) return false;
+                }
+                for (auto &flushing_page_id : shard.flushing_) {
+                    if (flushing_page_id.fd == fd) return false;
+                }
+                for (size_t frame_id = i; frame_id < max_pool_size_; frame_id += num_shards_) {
+                    if (pages_[frame_id].io_in_progress_ && pages_[frame_id].id_.fd == fd) return false;
+                }
+                return true;
+            });
+        }
+        for (size_t i = 0; i < max_pool_size_; i++) {
+            Page *page = &pages_[i];
+            //空闲帧和离线帧的pin_count为-1，其中可能留着旧的page_id
+            if (page->id_.fd == fd && page->id_.page_no != INVALID_PAGE_ID && page->pin_count_ >= 0) {
+                page->pin_count_++;
+                shards_[i % num_shards_].flushing_.insert(page->id_);
+                frame_ids.push_back(static_cast<frame_id_t>(i));
+            }
+        }
+    }
+
+    std::unique_ptr<char[]> buffer{new char[BUFFER_POOL_FLUSHER_BATCH * PAGE_SIZE]};  // 写回页面的副本
+    std::vector<bool> failed(frame_ids.size(), false);
+    // 所有写请求都完成之后再抛出第一个错误，保证返回时没有仍在使用副本的I/O
+    std::exception_ptr error;
+    for (size_t begin = 0; begin < frame_ids.size(); begin += BUFFER_POOL_FLUSHER_BATCH) {
+        size_t end = std::min<size_t>(begin + BUFFER_POOL_FLUSHER_BATCH, frame_ids.size());
+        std::vector<std::future<void>> writes(end - begin);
+        for (size_t i = begin; i < end; i++) {
+            Page *page = &pages_[frame_ids[i]];
+            char *copy = buffer.get() + (i - begin) * PAGE_SIZE;
+            try {
+                CopyPageForWrite(page, copy);
+                writes[i - begin] = disk_manager_->submit_write(page->id_.fd, page->id_.page_no, copy, PAGE_SIZE);
+            } catch (...) {
+                failed[i] = true;
+                if (!error) error = std::current_exception();
+            }
+        }
+        for (size_t i = begin; i < end; i++) {
+            try {
+                if (!failed[i]) writes[i - begin].get();
+            } catch (...) {
+                failed[i] = true;
+                if (!error) error = std::current_exception();
+            }
+        }
+    }
+
+    for (size_t i = 0; i < frame_ids.size(); i++) {
+        Page *page = &pages_[frame_ids[i]];
+        BufferPoolShard &shard = shards_[frame_ids[i] % num_shards_];
+        std::scoped_lock lock{shard.latch_};
+        shard.flushing_.erase(page->id_);
+        if (failed[i]) page->is_dirty_ = true;  //写回失败，恢复脏位
+        UnpinFrame(shard, frame_ids[i]);
+    }
+    for (size_t i = 0; i < num_shards_; i++) {
+        shards_[i].io_cv_.notify_all();
+    }
+    if (error) std::rethrow_exception(error);
+    //FlushAllPages是关闭文件前的最后一步，之后fd可能被其他文件复用，该文件的统计归入已关闭文件的合计
+    stats_->ReleaseFile(fd);
+}
+
+/**
+ * @brief WAL规则：日志开启时，页面上的修改对应的日志(page LSN)必须已经持久化，页面才能写回磁盘
+ */
+bool BufferPoolManager::CanWriteBack(Page *page) {
+    return log_manager_ == nullptr || !log_manager_->GetLogMode() || page->GetPageLsn() <= log_manager_->GetPersistentLsn();
+}
+
+/**
+ * @brief 后台写回线程主循环：每BUFFER_POOL_FLUSHER_INTERVAL_MS毫秒(或请求路径上淘汰了脏页时)依次清理每个分片
+ */
+void BufferPoolManager::RunFlusher() {
+    std::unique_ptr<char[]> buffer{new char[BUFFER_POOL_FLUSHER_BATCH * PAGE_SIZE]};  // 写回页面的副本
+    std::unique_lock<std::mutex> lock{flusher_latch_};
+    while (!stop_flusher_) {
+        flusher_cv_.wait_for(lock, std::chrono::milliseconds(BUFFER_POOL_FLUSHER_INTERVAL_MS));
+        if (stop_flusher_) {
+            break;
+        }
+        lock.unlock();
+        for (size_t i = 0; i < num_shards_; i++) {
+            try {
+                CleanShard(shards_[i], buffer.get());
+            } catch (std::exception &e) {  // 写回失败的页面仍是脏页，下一轮或淘汰时再写回
+                LOG_WARN("BufferPoolManager background flush failed: %s\n", e.what());
+            }
+        }
+        lock.lock();
+    }
+}
+
+/**
+ * @brief 分片中干净的可淘汰帧(空闲帧和pin_count为0的干净页面)不足分片帧数的flusher_clean_percent_%时，写回一批未被固定的脏页
+ * @note 持有latch选出脏页，认领帧(pin_count 0->-1)之后清除脏位、把页面复制到buffer中(写回期间被修改的页面会被UnpinPage重新置脏)并登记到flushing_；
+ * 释放latch之后再写回副本。写回期间帧不被固定，命中的FetchPage不受影响，帧也可以照常被淘汰；
+ * 淘汰时的写回、从磁盘重新读入以及FlushPage/DeletePage/FlushAllPages会等待flushing_中的写回完成
+ *
+ * @param buffer 至少BUFFER_POOL_FLUSHER_BATCH个页面大小的缓冲区
+ */
+void BufferPoolManager::CleanShard(BufferPoolShard &shard, char *buffer) {
+    size_t shard_index = &shard - shards_;
+    size_t pool_size = pool_size_;
+    if (pool_size <= shard_index) {
+        return;
+    }
+    size_t shard_frames = (pool_size - shard_index + num_shards_ - 1) / num_shards_;
+    size_t clean_target = shard_frames * flusher_clean_percent_ / 100;
+    std::vector<PageId> page_ids;
+    {
+        std::scoped_lock lock{shard.latch_};
+        size_t clean = shard.free_list_.size();
+        std::vector<Page *> dirty;
+        //从上次停下的位置开始扫描，未被固定的脏页都是淘汰候选，轮转选择使同一批页面不会被反复写回
+        for (size_t i = 0; i < shard_frames; i++) {
+            Page *page = &pages_[(shard.flush_cursor_ + i) % shard_frames * num_shards_ + shard_index];
+            if (page->pin_count_ != 0 || page->io_in_progress_) continue;
+            if (!page->is_dirty_) {
+                clean++;
+            } else if (shard.flushing_.count(page->id_) == 0 && CanWriteBack(page)) {
+                dirty.push_back(page);
+            }
+        }
+        if (clean >= clean_target) {
+            return;
+        }
+        size_t need = std::min<size_t>(clean_target - clean, BUFFER_POOL_FLUSHER_BATCH);
+        for (Page *page : dirty) {
+            if (page_ids.size() >= need) break;
+            //扫描之后帧可能已被无锁命中固定，CAS把pin_count从0改为-1认领该帧：复制期间无锁命中失败并转到持有latch的路径，
+            //没有线程能写页面；先清除脏位再复制，复制之后的修改会重新置脏
+            int expected = 0;
+            if (!page->pin_count_.compare_exchange_strong(expected, -1)) continue;
+            page->is_dirty_ = false;
+            memcpy(buffer + page_ids.size() * PAGE_SIZE, page->data_, PAGE_SIZE);
+            page->pin_count_ = 0;
+            shard.flushing_.insert(page->id_);
+            page_ids.push_back(page->id_);
+            shard.flush_cursor_ = (ToLocalFrame(static_cast<frame_id_t>(page - pages_)) + 1) % shard_frames;
+        }
+    }
+
+    //先提交所有写请求，再统一等待完成
+    std::vector<std::future<void>> writes(page_ids.size());
+    std::vector<bool> failed(page_ids.size(), false);
+    std::exception_ptr error;
+    for (size_t i = 0; i < page_ids.size(); i++) {
+        try {
+            SealPage(page_ids[i], buffer + i * PAGE_SIZE);  //在副本上计算，不需要持有latch
+            writes[i] = disk_manager_->submit_write(page_ids[i].fd, page_ids[i].page_no, buffer + i * PAGE_SIZE, PAGE_SIZE);
+        } catch (...) {
+            failed[i] = true;
+            if (!error) error = std::current_exception();
+        }
+    }
+    for (size_t i = 0; i < page_ids.size(); i++) {
+        try {
+            if (!failed[i]) writes[i].get();
+        } catch (...) {
+            failed[i] = true;
+            if (!error) error = std::current_exception();
+        }
+    }
+
+    {
+        std::scoped_lock lock{shard.latch_};
+        for (size_t i = 0; i < page_ids.size(); i++) {
+            shard.flushing_.erase(page_ids[i]);
+            frame_id_t frame_id;
+            //写回失败且页面仍在缓冲池中时恢复脏位；已经被淘汰的页面在淘汰时已经重新写回
+            if (failed[i] && shard.page_table_->Find(page_ids[i], &frame_id)) {
+                pages_[frame_id].is_dirty_ = true;
+            } else if (!failed[i]) {
+                stats_->Add(shard_index, page_ids[i].fd, BufferPoolStats::FLUSHER_WRITE);
+            }
+        }
+    }
+    shard.io_cv_.notify_all();
+    if (error) std::rethrow_exception(error);
+}
+
+/**
+ * @brief 预读提示，只把请求放入队列，由预读线程处理；队列已满时丢弃该请求
+ */
+void BufferPoolManager::Prefetch(PageId first_page_id, int num_pages) {
+    if (num_pages <= 0 || first_page_id.fd < 0 || first_page_id.fd >= DiskManager::MAX_FD) {
+        return;
+    }
+    {
+        std::scoped_lock lock{prefetch_latch_};
+        if (prefetch_queue_.size() >= BUFFER_POOL_PREFETCH_QUEUE_SIZE) {
+            return;
+        }
+        prefetch_queue_.emplace_back(first_page_id, num_pages);
+    }
+    prefetch_cv_.notify_one();
+}
+
+/**
+ * @brief 缺页时检测顺序访问：文件fd上连续两次缺页的页号相邻时，预读之后的若干个页面(最多BUFFER_POOL_READ_AHEAD_PAGES个)，
+ * 并把预期的下一次缺页设为预读范围之后的第一页，顺序扫描因此每预读一批页面才缺页一次
+ * @note 检测状态只是提示，多个线程同时访问同一文件时可以不精确
+ */
+void BufferPoolManager::DetectSequential(const PageId &page_id) {
+    if (BUFFER_POOL_READ_AHEAD_PAGES <= 0 || page_id.fd < 0 || page_id.fd >= DiskManager::MAX_FD) {
+        return;
+    }
+    //预读期间帧被固定，一次最多预读缓冲池的1/4，避免小缓冲池中的请求因为没有可淘汰的帧而失败
+    int num_pages = static_cast<int>(std::min<size_t>(BUFFER_POOL_READ_AHEAD_PAGES, pool_size_ / 4));
+    std::atomic<page_id_t> &next = read_ahead_next_[page_id.fd];
+    if (num_pages > 0 && next.load(std::memory_order_relaxed) == page_id.page_no) {
+        next.store(page_id.page_no + 1 + num_pages, std::memory_order_relaxed);
+        Prefetch(PageId{page_id.fd, page_id.page_no + 1}, num_pages);
+    } else {
+        next.store(page_id.page_no + 1, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief 预读线程主循环
+ */
+void BufferPoolManager::RunPrefetcher() {
+    std::unique_lock<std::mutex> lock{prefetch_latch_};
+    while (true) {
+        prefetch_cv_.wait(lock, [this]() { return stop_prefetcher_ || !prefetch_queue_.empty(); });
+        if (stop_prefetcher_) {
+            break;
+        }
+        auto request = prefetch_queue_.front();
+        prefetch_queue_.pop_front();
+        lock.unlock();
+        PrefetchPages(request.first, request.second);
+        lock.lock();
+    }
+}
+
+/**
+ * @brief 把页面异步读入缓冲池：先持有分片latch为每个页面分配帧(与FetchPage缺页相同，帧被固定并标记为I/O进行中)，
+ * 再一次性提交所有读请求并等待完成，最后解除固定，页面成为可淘汰页面
+ * @note 预读期间访问这些页面的FetchPage会在帧上等待I/O完成，而不会重复读入；读入失败的页面从缓冲池中移除
+ */
+void BufferPoolManager::PrefetchPages(PageId first_page_id, int num_pages) {
+    //只预读文件中已经分配的页面
+    page_id_t end_page_no = std::min<page_id_t>(first_page_id.page_no + num_pages,
+                                                disk_manager_->get_fd2pageno(first_page_id.fd));
+    std::vector<PageId> page_ids;
+    for (page_id_t page_no = first_page_id.page_no; page_no < end_page_no; page_no++) {
+        page_ids.push_back(PageId{first_page_id.fd, page_no});
+    }
+    PrefetchPages(page_ids);
+}
+
+/**
+ * @brief 把page_ids中的页面异步读入缓冲池，页面必须是文件中已经分配的页面
+ */
+void BufferPoolManager::PrefetchPages(const std::vector<PageId> &page_ids) {
+    struct PendingRead {
+        BufferPoolShard *shard;
+        frame_id_t frame_id;
+        std::future<void> read;
+    };
+    std::vector<PendingRead> pending;
+    for (const PageId &page_id : page_ids) {
+        BufferPoolShard &shard = GetShard(page_id);
+        std::unique_lock<std::mutex> lock{shard.latch_};
+        frame_id_t frame_id;
+        if (shard.page_table_->Find(page_id, &frame_id) || shard.writing_back_.count(page_id) > 0 ||
+            shard.flushing_.count(page_id) > 0) {
+            continue;  //已经在缓冲池中，或者刚被淘汰正在写回
+        }
+        if (!FindVictimPage(shard, &frame_id)) {
+            break;  //没有可淘汰的帧，放弃剩余的预读
+        }
+        Page *page = &pages_[frame_id];
+        PageId old_page_id;
+        bool write_back = UpdatePage(shard, page, page_id, frame_id, &old_page_id);
+        shard.prefetching_++;
+        lock.unlock();
+        if (write_back) {  //需要先写回脏页，同步完成，不与其他预读并行
+            bool filled = true;
+            try {
+                FillFrame(shard, page, frame_id, old_page_id, true, true);
+            } catch (std::exception &e) {  // FillFrame已经释放了该帧
+                filled = false;
+            }
+            lock.lock();
+            if (filled) UnpinFrame(shard, frame_id);
+            shard.prefetching_--;
+            lock.unlock();
+            shard.io_cv_.notify_all();
+            continue;
+        }
+        PendingRead read{&shard, frame_id, {}};
+        try {
+            read.read = disk_manager_->submit_read(page_id.fd, page_id.page_no, page->data_, PAGE_SIZE);
+        } catch (std::exception &e) {  // 留给下面统一处理，future无效表示提交失败
+        }
+        pending.push_back(std::move(read));
+    }
+
+    for (auto &read : pending) {
+        bool failed = !read.read.valid();
+        try {
+            if (!failed) {
+                read.read.get();
+                VerifyPage(*read.shard, pages_[read.frame_id].id_, pages_[read.frame_id].data_);
+            }
+        } catch (std::exception &e) {
+            failed = true;
+        }
+        BufferPoolShard &shard = *read.shard;
+        Page *page = &pages_[read.frame_id];
+        {
+            std::scoped_lock lock{shard.latch_};
+            page->io_in_progress_ = false;
+            if (failed) {  //等待该页面的线程发现page_id不匹配后会自己重新读入
+                shard.page_table_->Erase(page->id_);
+                page->id_.page_no = INVALID_PAGE_ID;
+            } else {
+                stats_->Add(ShardIndex(shard), page->id_.fd, BufferPoolStats::PREFETCH);
+            }
+            UnpinFrame(shard, read.frame_id);  //释放预读的固定，页面成为可淘汰页面(失败时帧回到free_list)
+            shard.prefetching_--;
+        }
+        shard.io_cv_.notify_all();
+    }
+}
+
+/**
+ * @brief 校验刚从磁盘读入的页面，文件没有启用页面校验和时什么都不做
+ * @note 校验失败时抛出InternalError，由读入页面的调用者按I/O错误处理(释放该帧)
+ */
+void BufferPoolManager::VerifyPage(BufferPoolShard &shard, const PageId &page_id, const char *data) {
+    if (!disk_manager_->has_page_checksum(page_id.fd) || Page::VerifyChecksum(data)) {
+        return;
+    }
+    stats_->Add(ShardIndex(shard), page_id.fd, BufferPoolStats::CHECKSUM_FAILURE);
+    throw InternalError("Page checksum mismatch, fd: " + std::to_string(page_id.fd) +
+                        ", page_no: " + std::to_string(page_id.page_no));
+}
+
+/**
+ * @brief 把page_id移出缓冲池，丢弃帧中的内容(不写回)，帧放回free_list；调用者需持有shard.latch_并已等待I/O完成
+ * @return 页面不在缓冲池中或已被移出时返回true，页面被固定时返回false
+ */
+bool BufferPoolManager::DiscardPage(BufferPoolShard &shard, const PageId &page_id) {
+    frame_id_t frame_id;
+    if (!shard.page_table_->Find(page_id, &frame_id)) {
+        return true;
+    }
+    Page *page = &pages_[frame_id];
+    int expected = 0;
+    if (!page->pin_count_.compare_exchange_strong(expected, -1)) {
+        return false;
+    }
+    shard.page_table_->Erase(page_id);
+    shard.replacer_->Pin(ToLocalFrame(frame_id)); //从replacer中移除，避免该帧同时出现在free_list和replacer中
+    page->id_.page_no = INVALID_PAGE_ID;
+    page->is_dirty_ = false;
+    ReleaseFrame(shard, frame_id); //释放，插入到可用帧列表
+    return true;
+}
+
+/**
+ * @brief Resize缩小时下线一个帧：帧中未被固定的页面写回(脏页)后移出缓冲池
+ * @note 调用前帧号已经不小于pool_size_，帧不会再回到free_list；pin_count为-1的帧已经是空闲帧，直接视为下线
+ * @return 帧是否已经下线；帧被固定时返回false，由调用者稍后重试
+ */
+bool BufferPoolManager::RemoveFrame(BufferPoolShard &shard, frame_id_t frame_id) {
+    std::unique_lock<std::mutex> lock{shard.latch_};
+    Page *page = &pages_[frame_id];
+    int expected = 0;
+    if (page->pin_count_ == -1) {
+        return true;
+    }
+    if (!page->pin_count_.compare_exchange_strong(expected, -1)) {
+        return false;  //有线程正在使用该页(包括无锁命中和正在进行的I/O)
+    }
+    //与淘汰相同：移出replacer和页表，脏页登记为正在写回，写回完成前其他线程不能从磁盘读入该页
+    shard.replacer_->Pin(ToLocalFrame(frame_id));
+    PageId old_page_id = page->id_;
+    bool write_back = page->is_dirty_ || shard.flushing_.count(old_page_id) > 0;
+    if (old_page_id.page_no != INVALID_PAGE_ID) {
+        stats_->Add(ShardIndex(shard), old_page_id.fd, BufferPoolStats::EVICTION);
+    }
+    shard.page_table_->Erase(old_page_id);
+    page->id_.page_no = INVALID_PAGE_ID;
+    page->is_dirty_ = false;
+    if (!write_back) {
+        return true;
+    }
+    shard.writing_back_.insert(old_page_id);
+    shard.io_cv_.wait(lock, [&]() { return shard.flushing_.count(old_page_id) == 0; });
+    lock.unlock();
+    std::exception_ptr error;
+    try {
+        SealPage(old_page_id, page->data_);
+        disk_manager_->submit_write(old_page_id.fd, old_page_id.page_no, page->data_, PAGE_SIZE).get();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    lock.lock();
+    shard.writing_back_.erase(old_page_id);
+    if (error) {  //写回失败，把页面放回缓冲池
+        page->id_ = old_page_id;
+        page->is_dirty_ = true;
+        shard.page_table_->Insert(old_page_id, frame_id);
+        page->pin_count_ = 0;
+        shard.replacer_->Unpin(ToLocalFrame(frame_id));
+    }
+    lock.unlock();
+    shard.io_cv_.notify_all();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return true;
+}
+
+/**
+ * @brief 在线调整缓冲池的帧数
+ */
+bool BufferPoolManager::Resize(size_t new_pool_size, std::chrono::milliseconds timeout) {
+    if (new_pool_size == 0 || new_pool_size > max_pool_size_) {
+        return false;
+    }
+    std::scoped_lock resize_lock{resize_latch_};
+    size_t old_pool_size = pool_size_;
+    if (new_pool_size >= old_pool_size) {
+        //扩大：离线帧的pin_count已经是-1，放入所属分片的free_list即可；先发布pool_size_，
+        //否则新帧被取出使用后再释放时，ReleaseFrame会因为frame_id>=pool_size_而不把它放回free_list，帧就此丢失
+        pool_size_ = new_pool_size;
+        for (size_t frame_id = old_pool_size; frame_id < new_pool_size; frame_id++) {
+            BufferPoolShard &shard = shards_[frame_id % num_shards_];
+            std::scoped_lock lock{shard.latch_};
+            shard.free_list_.push_back(static_cast<frame_id_t>(frame_id));
+        }
+        return true;
+    }
+
+    //缩小：先降低pool_size_，此后要下线的帧释放时不会再回到free_list，再把其中的空闲帧一次性移出free_list
+    pool_size_ = new_pool_size;
+    for (size_t i = 0; i < num_shards_; i++) {
+        std::scoped_lock lock{shards_[i].latch_};
+        shards_[i].free_list_.remove_if(
+            [new_pool_size](frame_id_t frame_id) { return static_cast<size_t>(frame_id) >= new_pool_size; });
+    }
+    //从帧号最大的帧开始逐个下线，超时或写回失败时保留还没有下线的帧，它们中的空闲帧放回free_list
+    auto restore = [&](size_t online_frames) {
+        pool_size_ = online_frames;
+        for (size_t frame_id = new_pool_size; frame_id < online_frames; frame_id++) {
+            BufferPoolShard &shard = shards_[frame_id % num_shards_];
+            std::scoped_lock lock{shard.latch_};
+            if (pages_[frame_id].pin_count_ == -1) {
+                shard.free_list_.push_back(static_cast<frame_id_t>(frame_id));
+            }
+        }
+        arena_->Release(online_frames, old_pool_size);
+    };
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (size_t frame_id = old_pool_size; frame_id > new_pool_size; frame_id--) {
+        BufferPoolShard &shard = shards_[(frame_id - 1) % num_shards_];
+        try {
+            while (!RemoveFrame(shard, static_cast<frame_id_t>(frame_id - 1))) {
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    restore(frame_id);
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));  // UnpinPage是无锁的，只能轮询
+            }
+        } catch (...) {
+            restore(frame_id);
+            throw;
+        }
+    }
+    arena_->Release(new_pool_size, old_pool_size);
+    return true;
+}
+
+/**
+ * @brief 转储热页列表：持有各分片latch收集在线帧中的页面及其访问纪元，按纪元从新到旧排序后写入文件，
+ * 文件每行为"页号 文件名"
+ */
+void BufferPoolManager::DumpHotPages(const std::string &path) {
+    std::vector<std::pair<uint32_t, PageId>> pages;
+    size_t pool_size = pool_size_;
+    for (size_t i = 0; i < num_shards_; i++) {
+        std::scoped_lock lock{shards_[i].latch_};
+        for (size_t frame_id = i; frame_id < pool_size; frame_id += num_shards_) {
+            Page *page = &pages_[frame_id];
+            if (page->pin_count_ >= 0 && page->id_.page_no != INVALID_PAGE_ID) {
+                pages.emplace_back(page->access_epoch_.load(std::memory_order_relaxed), page->id_);
+            }
+        }
+    }
+    access_epoch_++;  //此后被访问的页面排在本次转储的所有页面之前
+    std::stable_sort(pages.begin(), pages.end(),
+                     [](const auto &x, const auto &y) { return x.first > y.first; });
+
+    std::unordered_map<int, std::string> file_names;
+    std::string tmp_path = path + ".tmp";
+    std::ofstream out(tmp_path, std::ios::trunc);
+    for (auto &[epoch, page_id] : pages) {
+        auto it = file_names.find(page_id.fd);
+        if (it == file_names.end()) {
+            std::string file_name;
+            try {
+                file_name = disk_manager_->GetFileName(page_id.fd);
+            } catch (FileNotOpenError &e) {  //文件已经关闭，跳过它的页面
+            }
+            it = file_names.emplace(page_id.fd, file_name).first;
+        }
+        if (!it->second.empty()) {
+            out << page_id.page_no << ' ' << it->second << '\n';
+        }
+    }
+    out.close();
+    if (!out || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        unlink(tmp_path.c_str());
+        throw UnixError();
+    }
+}
+
+void BufferPoolManager::StartHotPageDump(const std::string &path, std::chrono::milliseconds interval) {
+    if (dumper_.joinable()) {
+        return;
+    }
+    dump_path_ = path;
+    dump_interval_ = interval;
+    dumper_ = std::thread(&BufferPoolManager::RunDumper, this);
+}
+
+/**
+ * @brief 热页转储线程主循环，退出前(缓冲池析构时)再转储一次，使正常关闭后的列表是最新的
+ */
+void BufferPoolManager::RunDumper() {
+    std::unique_lock<std::mutex> lock{dumper_latch_};
+    while (true) {
+        bool stop = dumper_cv_.wait_for(lock, dump_interval_, [this]() { return stop_dumper_; });
+        lock.unlock();
+        try {
+            DumpHotPages(dump_path_);
+        } catch (std::exception &e) {
+            LOG_WARN("BufferPoolManager failed to dump hot pages: %s\n", e.what());
+        }
+        lock.lock();
+        if (stop) {
+            break;
+        }
+    }
+}
+
+size_t BufferPoolManager::WarmUp(const std::string &path, bool background) {
+    std::ifstream in(path);
+    if (!in) {
+        return 0;
+    }
+    //列表中最近访问的页面在前，只取缓冲池能容纳的部分
+    std::vector<PageId> page_ids;
+    std::unordered_map<std::string, int> fds;
+    page_id_t page_no;
+    std::string file_name;
+    while (page_ids.size() < pool_size_ && in >> page_no && in.get() == ' ' && std::getline(in, file_name)) {
+        auto it = fds.find(file_name);
+        if (it == fds.end()) {
+            it = fds.emplace(file_name, disk_manager_->FindOpenedFile(file_name)).first;
+        }
+        int fd = it->second;
+        if (fd >= 0 && page_no >= 0 && page_no < disk_manager_->get_fd2pageno(fd)) {
+            page_ids.push_back(PageId{fd, page_no});
+        }
+    }
+    //按文件和页号排序，相邻的页面在同一批中读入
+    std::sort(page_ids.begin(), page_ids.end(), [](const PageId &x, const PageId &y) {
+        return x.fd != y.fd ? x.fd < y.fd : x.page_no < y.page_no;
+    });
+    size_t num_pages = page_ids.size();
+    if (background) {
+        if (warm_up_.joinable()) {
+            warm_up_.join();
+        }
+        warm_up_ = std::thread(&BufferPoolManager::LoadPages, this, std::move(page_ids));
+    } else {
+        LoadPages(page_ids);
+    }
+    return num_pages;
+}
+
+/**
+ * @brief 分批读入预热的页面，每批的读请求同时提交；一批中的帧在读入期间被固定，因此每批最多占缓冲池的1/4
+ */
+void BufferPoolManager::LoadPages(const std::vector<PageId> &page_ids) {
+    size_t batch = std::max<size_t>(std::min<size_t>(BUFFER_POOL_WARM_UP_BATCH, pool_size_ / 4), 1);
+    for (size_t begin = 0; begin < page_ids.size() && !stop_warm_up_; begin += batch) {
+        size_t end = std::min(begin + batch, page_ids.size());
+        PrefetchPages(std::vector<PageId>(page_ids.begin() + begin, page_ids.begin() + end));
+    }
+}
+
+std::string BufferPoolManager::GetStatsReport() {
+    BufferPoolStats::Snapshot snapshot = GetStats();
+    std::string report;
+    char line[512];
+    snprintf(line, sizeof(line), "pool_size: %zu, shards: %zu\n", GetPoolSize(), num_shards_);
+    report += line;
+    snprintf(line, sizeof(line), "%-32s %12s %12s %9s %12s %12s %14s %12s %17s\n", "file", "hits", "misses",
+             "hit_ratio", "evictions", "write_backs", "flusher_writes", "prefetches", "checksum_failures");
+    report += line;
+    auto print_file = [&](const std::string &name, const std::vector<uint64_t> &counters) {
+        uint64_t accesses = counters[BufferPoolStats::HIT] + counters[BufferPoolStats::MISS];
+        double hit_ratio = accesses == 0 ? 0 : 100.0 * counters[BufferPoolStats::HIT] / accesses;
+        snprintf(line, sizeof(line), "%-32s %12lu %12lu %8.2f%% %12lu %12lu %14lu %12lu %17lu\n", name.c_str(),
+                 counters[BufferPoolStats::HIT], counters[BufferPoolStats::MISS], hit_ratio,
+                 counters[BufferPoolStats::EVICTION], counters[BufferPoolStats::DIRTY_WRITE_BACK],
+                 counters[BufferPoolStats::FLUSHER_WRITE], counters[BufferPoolStats::PREFETCH],
+                 counters[BufferPoolStats::CHECKSUM_FAILURE]);
+        report += line;
+    };
+    std::vector<uint64_t> total(BufferPoolStats::NUM_COUNTERS, 0);
+    for (auto &[fd, counters] : snapshot.files) {
+        std::string name;
+        try {
+            name = disk_manager_->GetFileName(fd);
+        } catch (FileNotOpenError &e) {  //文件关闭之后才发生的事件(如淘汰该文件留下的页面)
+            name = "(closed fd " + std::to_string(fd) + ")";
+        }
+        print_file(name, counters);
+        for (int i = 0; i < BufferPoolStats::NUM_COUNTERS; i++) {
+            total[i] += counters[i];
+        }
+    }
+    if (std::any_of(snapshot.closed.begin(), snapshot.closed.end(), [](uint64_t n) { return n != 0; })) {
+        print_file("(closed files)", snapshot.closed);
+        for (int i = 0; i < BufferPoolStats::NUM_COUNTERS; i++) {
+            total[i] += snapshot.closed[i];
+        }
+    }
+    print_file("total", total);
+
+    snprintf(line, sizeof(line), "\n%-12s %12s %12s %12s %12s %12s %12s\n", "latency(ns)", "count", "mean", "p50",
+             "p90", "p99", "p99.9");
+    report += line;
+    for (int i = 0; i < BufferPoolStats::NUM_LATENCIES; i++) {
+        auto latency = static_cast<BufferPoolStats::Latency>(i);
+        snprintf(line, sizeof(line), "%-12s %12lu %12.0f %12lu %12lu %12lu %12lu\n", BufferPoolStats::LATENCY_NAMES[i],
+                 snapshot.Count(latency), snapshot.Mean(latency), snapshot.Percentile(latency, 50),
+                 snapshot.Percentile(latency, 90), snapshot.Percentile(latency, 99), snapshot.Percentile(latency, 99.9));
+        report += line;
+    }
+    return report;
+}
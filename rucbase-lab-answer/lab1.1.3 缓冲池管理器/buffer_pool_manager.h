@@ -0,0 +1,394 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_manager.h
+//
+// Identification: src/include/buffer/buffer_pool_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// buffer_pool_manager.h
+//
+// Identification: src/storage/buffer_pool_manager.h
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <chrono>  // NOLINT
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "common/logger.h"  // for debug
+#include "disk_manager.h"
+#include "buffer_pool_stats.h"
+#include "errors.h"
+#include "frame_arena.h"
+#include "page.h"
+#include "page_guard.h"
+#include "page_table.h"
+#include "replacer/clock_replacer.h"
+#include "replacer/lru_k_replacer.h"
+#include "replacer/lru_replacer.h"
+#include "replacer/replacer.h"
+#include "replacer/two_queue_replacer.h"
+
+class LogManager;
+
+/**
+ * @brief 缓冲池的一个分片：按PageIdHash把页面划分到num_shards_个分片中，每个分片拥有自己的页表、空闲帧链表、
+ * 替换策略和latch，不同分片上的缺页处理互不阻塞；命中的FetchPage和UnpinPage不需要latch
+ * @note 全局帧frame_id属于第frame_id % num_shards_个分片，在分片的replacer中的编号为frame_id / num_shards_
+ */
+struct BufferPoolShard {
+    /**
+     * @brief <PageId,frame_id_t>页表，开放寻址，查找无锁，修改需持有latch_
+     * @note 用于根据PageId定位其在BufferPool中的frame_id_t(全局帧号)
+     */
+    std::unique_ptr<PageTable> page_table_;
+    /**
+     * @brief 本分片空闲帧的id(全局帧号)构成的链表
+     */
+    std::list<frame_id_t> free_list_;
+    /**
+     * @brief 本分片的页面替换策略类，使用分片内的帧编号
+     */
+    Replacer *replacer_ = nullptr;
+    /** This latch serializes page table updates, free list and frame reassignment of this shard */
+    std::mutex latch_;
+    /**
+     * @brief 已被淘汰、正在写回磁盘的脏页，写回完成之前不能从磁盘重新读入这些页面
+     */
+    std::unordered_set<PageId, PageIdHash> writing_back_;
+    /**
+     * @brief 后台写回线程正在写回的页面(写回的是页面的副本，页面仍在缓冲池中)，写回完成之前这些页面不能再被写回或从磁盘读入
+     */
+    std::unordered_set<PageId, PageIdHash> flushing_;
+    /** 帧的I/O完成(io_in_progress_被清除)或写回完成时通知等待者，与latch_配合使用 */
+    std::condition_variable io_cv_;
+    /** 预读线程正在读入(因而被固定)的帧数，缺页找不到可淘汰的帧时，如果它不为0则等待预读完成后重试 */
+    size_t prefetching_ = 0;
+    /** 后台写回线程下一轮从分片内的第几个帧开始扫描，使每轮写回的帧轮转 */
+    size_t flush_cursor_ = 0;
+};
+
+class BufferPoolManager {
+   private:
+    /**
+     * @brief Number of pages in the buffer pool.
+     * @note 帧号小于pool_size_的帧在线(属于缓冲池)，[pool_size_, max_pool_size_)的帧离线：pin_count为-1，不在free_list中
+     */
+    std::atomic<size_t> pool_size_;
+    /**
+     * @brief 缓冲池最多可以扩大到的帧数，构造时按它分配帧的元数据、数据区(只占虚拟地址空间)、页表和replacer
+     */
+    size_t max_pool_size_;
+    /** 串行化Resize */
+    std::mutex resize_latch_;
+    /**
+     * @brief BufferPool中的Page对象数组(指针)，只保存帧的元数据，按帧号与arena_中的数据区一一对应
+     * @note 在构造函数中申请内存空间,折构函数中释放,大小为BUFFER_POOL_SIZE
+     */
+    Page *pages_;
+    /**
+     * @brief 所有帧的数据区，大页映射，与元数据分开存放
+     */
+    std::unique_ptr<FrameArena> arena_;
+    /**
+     * @brief 分片个数，以及分片数组
+     */
+    size_t num_shards_;
+    BufferPoolShard *shards_;
+    /** 上层传入disk_manager */
+    DiskManager *disk_manager_;
+    /** 日志管理器，写回页面前检查WAL规则；为nullptr时不检查 */
+    LogManager *log_manager_ = nullptr;
+    /**
+     * @brief 后台写回线程：周期性地把冷的脏页写回磁盘，使每个分片保持flusher_clean_percent_%的干净可淘汰帧，
+     * 淘汰时就不需要在请求路径上同步写回脏页
+     */
+    std::thread flusher_;
+    std::mutex flusher_latch_;
+    std::condition_variable flusher_cv_;
+    bool stop_flusher_ = false;
+    size_t flusher_clean_percent_;
+    /**
+     * @brief 预读线程：处理Prefetch()提交的预读请求，异步地把页面读入缓冲池，读入期间不阻塞请求线程
+     * @note prefetch_queue_中每个请求为(起始页面, 页数)
+     */
+    std::thread prefetcher_;
+    std::mutex prefetch_latch_;
+    std::condition_variable prefetch_cv_;
+    std::deque<std::pair<PageId, int>> prefetch_queue_;
+    bool stop_prefetcher_ = false;
+    /**
+     * @brief 顺序访问检测：每个文件下一个预期缺页的页号，缺页的页号与之相同时说明在顺序访问该文件，触发预读
+     */
+    std::unique_ptr<std::atomic<page_id_t>[]> read_ahead_next_;
+    /**
+     * @brief 访问纪元：FetchPage/NewPage把当前纪元记在页面上，每次转储热页列表后加1，
+     * 热页列表因此按最近访问的先后排序(同一纪元内的页面之间不分先后)
+     */
+    std::atomic<uint32_t> access_epoch_{1};
+    /**
+     * @brief 热页转储线程：每dump_interval_把缓冲池中的页面列表转储到dump_path_，析构时再转储一次
+     */
+    std::thread dumper_;
+    std::mutex dumper_latch_;
+    std::condition_variable dumper_cv_;
+    bool stop_dumper_ = false;
+    std::string dump_path_;
+    std::chrono::milliseconds dump_interval_{BUFFER_POOL_HOT_PAGES_DUMP_INTERVAL_MS};
+    /**
+     * @brief 后台预热线程，析构时设置stop_warm_up_使其尽快结束
+     */
+    std::thread warm_up_;
+    std::atomic<bool> stop_warm_up_{false};
+    /**
+     * @brief 命中/缺页/淘汰/写回等计数(按分片和文件)以及延迟直方图
+     */
+    std::unique_ptr<BufferPoolStats> stats_;
+
+   public:
+    /**
+     * @param pool_size 缓冲池的帧数
+     * @param disk_manager 上层传入的disk_manager
+     * @param num_shards 分片数，为0时按pool_size自动选择(每个分片至少BUFFER_POOL_MIN_SHARD_FRAMES帧，
+     * 最多BUFFER_POOL_MAX_SHARDS个分片)
+     * @param replacer_type 替换策略："LRU", "CLOCK", "LRU-K" 或 "2Q"，默认使用配置中的REPLACER_TYPE
+     * @param flusher_clean_percent 后台写回线程为每个分片保持的干净可淘汰帧比例(%)，为0时不启动后台写回线程
+     * @param max_pool_size Resize最多可以扩大到的帧数，小于pool_size时等于pool_size
+     */
+    BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_shards = 0,
+                      const std::string &replacer_type = REPLACER_TYPE,
+                      size_t flusher_clean_percent = BUFFER_POOL_FLUSHER_CLEAN_PERCENT, size_t max_pool_size = 0);
+
+    /**
+     * @brief Destroy the Buffer Pool object
+     *
+     */
+    ~BufferPoolManager();
+
+   public:
+    /**
+     * Fetch the requested page from the buffer pool.
+     * @param page_id id of page to be fetched
+     * @return the requested page
+     */
+    Page *FetchPage(PageId page_id);
+
+    /**
+     * @brief FetchPage的RAII版本：返回持有页面固定的guard，guard析构时自动UnpinPage；
+     * Read/Write版本还会在固定之后加页面的读/写锁。没有可用的帧时返回空guard(GetPage()为nullptr)
+     */
+    BasicPageGuard FetchPageBasic(PageId page_id) { return BasicPageGuard(this, FetchPage(page_id)); }
+
+    ReadPageGuard FetchPageRead(PageId page_id) { return ReadPageGuard(this, FetchPage(page_id)); }
+
+    WritePageGuard FetchPageWrite(PageId page_id) { return WritePageGuard(this, FetchPage(page_id)); }
+
+    /** @brief 只固定页面、不加页面锁，由调用者通过页面版本号验证读到的数据 */
+    OptimisticPageGuard FetchPageOptimistic(PageId page_id) { return OptimisticPageGuard(this, FetchPage(page_id)); }
+
+    /**
+     * @brief NewPage的RAII版本，返回持有新页面写锁的guard
+     */
+    WritePageGuard NewPageGuarded(PageId *page_id) { return WritePageGuard(this, NewPage(page_id)); }
+
+    /**
+     * Unpin the target page from the buffer pool.
+     * @param page_id id of page to be unpinned
+     * @param is_dirty true if the page should be marked as dirty, false otherwise
+     * @return false if the page pin count is <= 0 before this call, true otherwise
+     */
+    bool UnpinPage(PageId page_id, bool is_dirty);
+
+    /**
+     * Flushes the target page to disk.
+     * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+     * @return false if the page could not be found in the page table, true otherwise
+     */
+    bool FlushPage(PageId page_id);
+
+    /**
+     * Creates a new page in the buffer pool.
+     * @param[out] page_id id of created page
+     * @return nullptr if no new pages could be created, otherwise pointer to new page
+     */
+    Page *NewPage(PageId *page_id);
+
+    /**
+     * Deletes a page from the buffer pool.
+     * @param page_id id of page to be deleted
+     * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+     */
+    bool DeletePage(PageId page_id);
+
+    /**
+     * Flushes all the pages in the buffer pool to disk.
+     * @note 关闭文件前调用；写回成功后该文件的统计计数归入已关闭文件的合计，fd被复用时新文件从0开始统计
+     */
+    void FlushAllPages(int fd);
+
+    /**
+     * @brief 预读提示：把页面[first_page_id.page_no, first_page_id.page_no + num_pages)异步读入缓冲池，立即返回
+     * @note 只是提示：已经在缓冲池中的页面、超出文件已分配范围的页面会被跳过，缓冲池中没有可淘汰的帧时停止预读
+     */
+    void Prefetch(PageId first_page_id, int num_pages);
+
+    size_t GetPoolSize() const { return pool_size_; }
+
+    size_t GetMaxPoolSize() const { return max_pool_size_; }
+
+    /**
+     * @brief 在线调整缓冲池的帧数，调整期间FetchPage/UnpinPage等照常运行
+     * @note 扩大时把新的帧放入free_list；缩小时从帧号最大的帧开始逐个下线：空闲帧直接移出free_list，
+     * 未被固定的页面先写回(脏页)再移出缓冲池，被固定的帧等待其解除固定，最后把下线帧的内存归还给操作系统
+     *
+     * @param new_pool_size 新的帧数，范围[1, max_pool_size]
+     * @param timeout 缩小时等待被固定的帧的最长时间
+     * @return 是否调整到了new_pool_size；缩小超时(有页面一直被固定)时返回false，缓冲池保持已经下线部分帧之后的大小
+     */
+    bool Resize(size_t new_pool_size,
+                std::chrono::milliseconds timeout = std::chrono::milliseconds(BUFFER_POOL_RESIZE_TIMEOUT_MS));
+
+    size_t GetNumShards() const { return num_shards_; }
+
+    /**
+     * @brief 把缓冲池中的页面列表(文件名和页号)转储到path，最近访问的页面在前
+     * @note 先写入临时文件再rename，崩溃时不会留下不完整的列表；已关闭文件的页面不转储
+     */
+    void DumpHotPages(const std::string &path);
+
+    /**
+     * @brief 启动热页转储线程，每隔interval把页面列表转储到path，缓冲池析构时再转储一次
+     */
+    void StartHotPageDump(const std::string &path, std::chrono::milliseconds interval = std::chrono::milliseconds(
+                                                                       BUFFER_POOL_HOT_PAGES_DUMP_INTERVAL_MS));
+
+    /**
+     * @brief 按DumpHotPages转储的列表预热缓冲池：取最近访问的至多pool_size个页面，按(fd, page_no)排序后
+     * 每BUFFER_POOL_WARM_UP_BATCH页一批异步读入
+     * @note 只预热已经打开的文件中的页面，需要在打开数据库之后调用；列表不存在时什么都不做
+     * @param background 为true时在后台线程中预热并立即返回，否则读入完成后返回
+     * @return 要预热的页数
+     */
+    size_t WarmUp(const std::string &path, bool background = false);
+
+    /** @return 缓冲池统计信息的快照 */
+    BufferPoolStats::Snapshot GetStats() const { return stats_->GetSnapshot(); }
+
+    /**
+     * @brief 生成可读的统计报告(show buffer stats)：每个文件的命中率、淘汰和写回次数，以及各类操作的延迟分布
+     */
+    std::string GetStatsReport();
+
+    /**
+     * @brief 设置日志管理器，之后后台写回线程只写回page LSN不超过日志persistent LSN的脏页(WAL规则)
+     */
+    void SetLogManager(LogManager *log_manager) { log_manager_ = log_manager; }
+
+   private:
+    size_t ShardIndex(const BufferPoolShard &shard) const { return &shard - shards_; }
+
+    /** @brief 获取分片latch，统计等待时间 */
+    void LockShard(BufferPoolShard &shard, std::unique_lock<std::mutex> &lock) {
+        uint64_t start = BufferPoolStats::Now();
+        lock.lock();
+        stats_->RecordSince(ShardIndex(shard), BufferPoolStats::LATCH_WAIT, start);
+    }
+
+    /** @brief 记录一次FetchPage命中 */
+    void RecordHit(BufferPoolShard &shard, const PageId &page_id, uint64_t start) {
+        stats_->Add(ShardIndex(shard), page_id.fd, BufferPoolStats::HIT);
+        stats_->RecordSince(ShardIndex(shard), BufferPoolStats::FETCH_HIT, start);
+    }
+
+    /** @return page_id所属的分片 */
+    BufferPoolShard &GetShard(const PageId &page_id) { return shards_[PageIdHash()(page_id) % num_shards_]; }
+
+    /** @brief 全局帧号与分片replacer内帧号之间的转换 */
+    frame_id_t ToLocalFrame(frame_id_t frame_id) const { return frame_id / static_cast<frame_id_t>(num_shards_); }
+
+    frame_id_t ToGlobalFrame(const BufferPoolShard &shard, frame_id_t local_frame_id) const {
+        return local_frame_id * static_cast<frame_id_t>(num_shards_) + static_cast<frame_id_t>(&shard - shards_);
+    }
+
+    static Replacer *CreateReplacer(const std::string &replacer_type, size_t num_pages);
+
+    bool FindVictimPage(BufferPoolShard &shard, frame_id_t *frame_id);
+
+    bool UpdatePage(BufferPoolShard &shard, Page *page, PageId new_page_id, frame_id_t new_frame_id,
+                    PageId *old_page_id);
+
+    void FillFrame(BufferPoolShard &shard, Page *page, frame_id_t frame_id, const PageId &old_page_id,
+                   bool write_back, bool read);
+
+    void UnpinFrame(BufferPoolShard &shard, frame_id_t frame_id);
+
+    void ReleaseFrame(BufferPoolShard &shard, frame_id_t frame_id);
+
+    bool RemoveFrame(BufferPoolShard &shard, frame_id_t frame_id);
+
+    bool DiscardPage(BufferPoolShard &shard, const PageId &page_id);
+
+    /** @brief 文件启用了页面校验和时，写回前在data中填入校验和 */
+    void SealPage(const PageId &page_id, char *data) {
+        if (disk_manager_->has_page_checksum(page_id.fd)) {
+            Page::SetChecksum(data);
+        }
+    }
+
+    void VerifyPage(BufferPoolShard &shard, const PageId &page_id, const char *data);
+
+    void CopyPageForWrite(Page *page, char *buffer);
+
+    static bool TryPinFrame(Page *page);
+
+    bool WaitForFrame(BufferPoolShard &shard, std::unique_lock<std::mutex> &lock, frame_id_t frame_id,
+                      const PageId &page_id);
+
+    void WaitForIO(BufferPoolShard &shard, std::unique_lock<std::mutex> &lock, const PageId &page_id);
+
+    bool CanWriteBack(Page *page);
+
+    void RunFlusher();
+
+    void CleanShard(BufferPoolShard &shard, char *buffer);
+
+    void RunPrefetcher();
+
+    void PrefetchPages(PageId first_page_id, int num_pages);
+
+    void PrefetchPages(const std::vector<PageId> &page_ids);
+
+    void RunDumper();
+
+    void LoadPages(const std::vector<PageId> &page_ids);
+
+    /** @brief 在页面上记录当前访问纪元 */
+    void TouchPage(Page *page) const {
+        page->access_epoch_.store(access_epoch_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    void DetectSequential(const PageId &page_id);
+};
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "buffer_pool_stats.h"
+
+#include <algorithm>
+
+void LatencyHistogram::MergeInto(std::vector<uint64_t> *counts, uint64_t *sum) const {
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        (*counts)[i] += buckets_[i].load(std::memory_order_relaxed);
+    }
+    *sum += sum_.load(std::memory_order_relaxed);
+}
+
+BufferPoolStats::BufferPoolStats(size_t num_shards) : num_shards_(num_shards), shards_(new ShardStats[num_shards]) {}
+
+BufferPoolStats::~BufferPoolStats() {
+    for (size_t i = 0; i < num_shards_; i++) {
+        for (auto &chunk : shards_[i].chunks_) {
+            delete[] chunk.load();
+        }
+    }
+}
+
+/**
+ * @brief 取分片中fd的计数器，所在的组还没有分配时分配并CAS发布；CAS失败说明其他线程已经分配，释放自己分配的
+ */
+BufferPoolStats::FileCounters *BufferPoolStats::GetFileCounters(size_t shard, int fd) {
+    std::atomic<FileCounters *> &chunk = shards_[shard].chunks_[fd / FILES_PER_CHUNK];
+    FileCounters *counters = chunk.load(std::memory_order_acquire);
+    if (counters == nullptr) {
+        FileCounters *allocated = new FileCounters[FILES_PER_CHUNK];
+        if (chunk.compare_exchange_strong(counters, allocated, std::memory_order_acq_rel)) {
+            counters = allocated;
+        } else {
+            delete[] allocated;
+        }
+    }
+    return &counters[fd % FILES_PER_CHUNK];
+}
+
+/**
+ * @brief 逐个计数器exchange(0)后累加到closed_，与并发的Add交错时不会丢失计数
+ */
+void BufferPoolStats::ReleaseFile(int fd) {
+    if (fd < 0 || fd >= MAX_FILES) {
+        return;
+    }
+    for (size_t i = 0; i < num_shards_; i++) {
+        FileCounters *counters = shards_[i].chunks_[fd / FILES_PER_CHUNK].load(std::memory_order_acquire);
+        if (counters == nullptr) {
+            continue;
+        }
+        for (int counter = 0; counter < NUM_COUNTERS; counter++) {
+            uint64_t n = counters[fd % FILES_PER_CHUNK].counters_[counter].exchange(0, std::memory_order_relaxed);
+            shards_[i].closed_.counters_[counter].fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+}
+
+BufferPoolStats::Snapshot BufferPoolStats::GetSnapshot() const {
+    Snapshot snapshot;
+    snapshot.closed.assign(NUM_COUNTERS, 0);
+    snapshot.latencies.assign(NUM_LATENCIES, std::vector<uint64_t>(LatencyHistogram::NUM_BUCKETS, 0));
+    snapshot.latency_sums.assign(NUM_LATENCIES, 0);
+    for (size_t i = 0; i < num_shards_; i++) {
+        const ShardStats &shard = shards_[i];
+        for (int latency = 0; latency < NUM_LATENCIES; latency++) {
+            shard.latencies_[latency].MergeInto(&snapshot.latencies[latency], &snapshot.latency_sums[latency]);
+        }
+        for (int counter = 0; counter < NUM_COUNTERS; counter++) {
+            snapshot.closed[counter] += shard.closed_.counters_[counter].load(std::memory_order_relaxed);
+        }
+        for (int chunk = 0; chunk < MAX_FILES / FILES_PER_CHUNK; chunk++) {
+            FileCounters *counters = shard.chunks_[chunk].load(std::memory_order_acquire);
+            if (counters == nullptr) {
+                continue;
+            }
+            for (int j = 0; j < FILES_PER_CHUNK; j++) {
+                for (int counter = 0; counter < NUM_COUNTERS; counter++) {
+                    uint64_t n = counters[j].counters_[counter].load(std::memory_order_relaxed);
+                    if (n == 0) {
+                        continue;
+                    }
+                    auto &file = snapshot.files[chunk * FILES_PER_CHUNK + j];
+                    file.resize(NUM_COUNTERS, 0);
+                    file[counter] += n;
+                }
+            }
+        }
+    }
+    return snapshot;
+}
+
+uint64_t BufferPoolStats::Snapshot::Total(Counter counter) const {
+    uint64_t total = closed[counter];
+    for (auto &[fd, counters] : files) {
+        total += counters[counter];
+    }
+    return total;
+}
+
+uint64_t BufferPoolStats::Snapshot::Count(Latency latency) const {
+    uint64_t count = 0;
+    for (uint64_t n : latencies[latency]) {
+        count += n;
+    }
+    return count;
+}
+
+uint64_t BufferPoolStats::Snapshot::Percentile(Latency latency, double p) const {
+    uint64_t count = Count(latency);
+    if (count == 0) {
+        return 0;
+    }
+    //第rank个(从1开始)记录所在的桶
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p / 100 * count + 0.5));
+    uint64_t seen = 0;
+    for (int i = 0; i < LatencyHistogram::NUM_BUCKETS; i++) {
+        seen += latencies[latency][i];
+        if (seen >= rank) {
+            return LatencyHistogram::BucketLowerBound(i);
+        }
+    }
+    return LatencyHistogram::BucketLowerBound(LatencyHistogram::NUM_BUCKETS - 1);
+}
+
+double BufferPoolStats::Snapshot::Mean(Latency latency) const {
+    uint64_t count = Count(latency);
+    return count == 0 ? 0 : static_cast<double>(latency_sums[latency]) / count;
+}
@@ -0,0 +1,173 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// buffer_pool_stats.h
+//
+// Identification: src/storage/buffer_pool_stats.h
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "common/config.h"
+
+/**
+ * @brief 无锁的延迟直方图(HDR风格的对数线性分桶)：小于2^SUB_BUCKET_BITS的值每个值一个桶，
+ * 之后每个2的幂区间均分为2^SUB_BUCKET_BITS个桶，任何值所在桶的相对误差不超过1/2^SUB_BUCKET_BITS
+ * @note 记录只做relaxed的原子加，读取得到的是近似一致的快照
+ */
+class LatencyHistogram {
+   public:
+    static constexpr int SUB_BUCKET_BITS = 3;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    void Record(uint64_t value) {
+        buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    static int BucketIndex(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<int>(value);
+        }
+        int shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    /** @return 第index个桶的下界 */
+    static uint64_t BucketLowerBound(int index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        int shift = index / SUB_BUCKETS - 1;
+        return static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    }
+
+    /** @brief 累加到快照的桶数组counts(NUM_BUCKETS个元素)和*sum中 */
+    void MergeInto(std::vector<uint64_t> *counts, uint64_t *sum) const;
+
+   private:
+    std::atomic<uint64_t> buckets_[NUM_BUCKETS]{};
+    std::atomic<uint64_t> sum_{0};
+};
+
+/**
+ * @brief 缓冲池统计信息：每个分片一份计数器和直方图(分片之间不共享cache line)，计数器再按文件细分
+ * @note 所有记录操作都是无锁的；文件的计数器按fd每FILES_PER_CHUNK个一组，在第一次用到时分配
+ */
+class BufferPoolStats {
+   public:
+    /** 按文件统计的事件 */
+    enum Counter {
+        HIT,               // FetchPage命中
+        MISS,              // FetchPage未命中，从磁盘读入
+        EVICTION,          // 页面被淘汰(包括Resize下线帧)
+        DIRTY_WRITE_BACK,  // 淘汰时同步写回的脏页
+        FLUSHER_WRITE,     // 后台写回线程写回的脏页
+        PREFETCH,          // 预读/预热读入的页面
+        CHECKSUM_FAILURE,  // 读入时校验和不一致的页面
+        NUM_COUNTERS
+    };
+
+    /** 延迟直方图的种类，单位为纳秒 */
+    enum Latency {
+        FETCH_HIT,   // 命中的FetchPage
+        FETCH_MISS,  // 未命中的FetchPage(包括淘汰写回和读入)
+        LATCH_WAIT,  // 请求路径上等待分片latch的时间
+        DISK_READ,   // 单个页面的磁盘读
+        DISK_WRITE,  // 单个页面的磁盘写
+        NUM_LATENCIES
+    };
+
+    static constexpr const char *COUNTER_NAMES[NUM_COUNTERS] = {"hits",        "misses",         "evictions",
+                                                                "write_backs", "flusher_writes", "prefetches",
+                                                                "checksum_failures"};
+    static constexpr const char *LATENCY_NAMES[NUM_LATENCIES] = {"fetch_hit", "fetch_miss", "latch_wait", "disk_read",
+                                                                 "disk_write"};
+
+    /** @brief 某一时刻的统计快照 */
+    struct Snapshot {
+        std::map<int, std::vector<uint64_t>> files;  // fd -> 每种Counter的计数，只包含有事件的文件
+        std::vector<uint64_t> closed;                // 已关闭文件的每种Counter的合计
+        std::vector<std::vector<uint64_t>> latencies;  // 每种Latency的直方图桶计数
+        std::vector<uint64_t> latency_sums;
+
+        uint64_t Total(Counter counter) const;
+        uint64_t Count(Latency latency) const;
+        /** @return 第p(0~100)百分位数所在桶的下界 */
+        uint64_t Percentile(Latency latency, double p) const;
+        double Mean(Latency latency) const;
+    };
+
+    explicit BufferPoolStats(size_t num_shards);
+
+    ~BufferPoolStats();
+
+    BufferPoolStats(const BufferPoolStats &) = delete;
+    BufferPoolStats &operator=(const BufferPoolStats &) = delete;
+
+    void Add(size_t shard, int fd, Counter counter, uint64_t n = 1) {
+        if (fd < 0 || fd >= MAX_FILES) {
+            return;
+        }
+        GetFileCounters(shard, fd)->counters_[counter].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 文件关闭时调用：把fd的计数器归入已关闭文件的合计并清零，fd被其他文件复用后从0开始统计
+     */
+    void ReleaseFile(int fd);
+
+    void RecordLatency(size_t shard, Latency latency, uint64_t nanos) {
+        shards_[shard].latencies_[latency].Record(nanos);
+    }
+
+    Snapshot GetSnapshot() const;
+
+    /** @return 计时用的当前时间(纳秒)，BUFFER_POOL_STATS_TIMING为false时返回0，不读取时钟 */
+    static uint64_t Now() {
+        if constexpr (!BUFFER_POOL_STATS_TIMING) {
+            return 0;
+        }
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /** @brief 记录从start(Now()的返回值)到现在的延迟 */
+    void RecordSince(size_t shard, Latency latency, uint64_t start) {
+        if constexpr (BUFFER_POOL_STATS_TIMING) {
+            RecordLatency(shard, latency, Now() - start);
+        }
+    }
+
+   private:
+    static constexpr int MAX_FILES = 8192;  // 与DiskManager::MAX_FD相同
+    static constexpr int FILES_PER_CHUNK = 64;
+
+    struct FileCounters {
+        std::atomic<uint64_t> counters_[NUM_COUNTERS]{};
+    };
+
+    struct alignas(64) ShardStats {
+        std::atomic<FileCounters *> chunks_[MAX_FILES / FILES_PER_CHUNK]{};
+        FileCounters closed_;  // 已关闭文件的合计
+        LatencyHistogram latencies_[NUM_LATENCIES];
+    };
+
+    FileCounters *GetFileCounters(size_t shard, int fd);
+
+    size_t num_shards_;
+    std::unique_ptr<ShardStats[]> shards_;
+};
@@ -0,0 +1,89 @@
+#include "frame_arena.h"
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "errors.h"
+
+FrameArena::FrameArena(size_t num_frames, bool use_huge_pages, bool numa_interleave) {
+    size_ = std::max<size_t>(num_frames, 1) * PAGE_SIZE;
+    // 至少有一个大页大小时才值得使用大页，映射长度向上取整到大页大小
+    if (use_huge_pages && size_ >= HUGE_PAGE_SIZE) {
+        size_t huge_size = (size_ + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        void *addr = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (addr != MAP_FAILED) {
+            base_ = static_cast<char *>(addr);
+            size_ = huge_size;
+            huge_tlb_ = true;
+        }
+    }
+    if (base_ == nullptr) {
+        void *addr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED) {
+            throw UnixError();
+        }
+        base_ = static_cast<char *>(addr);
+        if (use_huge_pages && size_ >= HUGE_PAGE_SIZE) {
+            madvise(base_, size_, MADV_HUGEPAGE);  // 只是建议，内核不支持透明大页时忽略
+        }
+    }
+    if (numa_interleave) {
+        Interleave();
+    }
+}
+
+FrameArena::~FrameArena() { munmap(base_, size_); }
+
+void FrameArena::Release(size_t first_frame, size_t last_frame) {
+    size_t begin = first_frame * PAGE_SIZE;
+    size_t end = std::min(last_frame * PAGE_SIZE, size_);
+    if (huge_tlb_) {
+        begin = (begin + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        end = end / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    }
+    if (begin < end) {
+        madvise(base_ + begin, end - begin, MADV_DONTNEED);
+    }
+}
+
+/**
+ * @brief 数据区还没有被访问、没有分配物理页，此时设置交错策略，之后缺页分配的物理页轮流来自各个NUMA结点
+ * @note 直接调用mbind系统调用，不依赖libnuma；只有一个结点或调用失败时什么都不做
+ */
+void FrameArena::Interleave() {
+    // /sys/devices/system/node/online的格式如"0"或"0-3,5"
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string ranges;
+    if (!(online >> ranges)) {
+        return;
+    }
+    std::vector<unsigned long> mask(1, 0);
+    int num_nodes = 0;
+    size_t pos = 0;
+    while (pos < ranges.size()) {
+        size_t end = ranges.find(',', pos);
+        if (end == std::string::npos) end = ranges.size();
+        std::string range = ranges.substr(pos, end - pos);
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int node = first; node <= last; node++) {
+            size_t word = node / (8 * sizeof(unsigned long));
+            if (word >= mask.size()) mask.resize(word + 1, 0);
+            mask[word] |= 1UL << (node % (8 * sizeof(unsigned long)));
+            num_nodes++;
+        }
+        pos = end + 1;
+    }
+    if (num_nodes <= 1) {
+        return;
+    }
+    syscall(SYS_mbind, base_, size_, MPOL_INTERLEAVE, mask.data(), mask.size() * 8 * sizeof(unsigned long) + 1, 0);
+}
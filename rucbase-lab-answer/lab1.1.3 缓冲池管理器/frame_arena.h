@@ -0,0 +1,60 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// frame_arena.h
+//
+// Identification: src/storage/frame_arena.h
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+
+/**
+ * @brief 缓冲池所有帧的数据区：一块连续的匿名映射内存，第frame_id个帧占[frame_id * PAGE_SIZE, (frame_id + 1) * PAGE_SIZE)
+ * 帧的元数据(Page对象)放在单独的数组中，数据区不再与元数据交错，可以用大页映射，减少TLB缺失
+ * @note 优先使用MAP_HUGETLB的2MB大页；系统没有预留大页时退回普通映射，并用madvise建议内核使用透明大页。
+ * 机器有多个NUMA结点时，数据区按页交错分配到所有结点上。映射得到的内存已经清零
+ */
+class FrameArena {
+   public:
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    /**
+     * @param num_frames 帧数
+     * @param use_huge_pages 是否尝试使用大页
+     * @param numa_interleave 是否把数据区交错分配到所有NUMA结点
+     */
+    FrameArena(size_t num_frames, bool use_huge_pages = BUFFER_POOL_USE_HUGE_PAGES,
+               bool numa_interleave = BUFFER_POOL_NUMA_INTERLEAVE);
+
+    ~FrameArena();
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    /** @return 第frame_id个帧的数据区，PAGE_SIZE对齐 */
+    char *GetFrame(size_t frame_id) const { return base_ + frame_id * PAGE_SIZE; }
+
+    /**
+     * @brief 把帧[first_frame, last_frame)的物理内存归还给操作系统，之后再访问这些帧时读到的是0
+     * @note 大页映射只能按整个大页归还，范围内不完整的大页保留
+     */
+    void Release(size_t first_frame, size_t last_frame);
+
+    /** @return 数据区是否由MAP_HUGETLB大页映射 */
+    bool IsHugeTlb() const { return huge_tlb_; }
+
+   private:
+    void Interleave();
+
+    char *base_ = nullptr;
+    size_t size_ = 0;  // 映射的字节数
+    bool huge_tlb_ = false;
+};
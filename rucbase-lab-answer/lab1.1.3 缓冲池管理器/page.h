@@ -0,0 +1,192 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page.h
+//
+// Identification: src/include/storage/page/page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// page.h
+//
+// Identification: src/storage/page.h
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include "common/config.h"
+#include "common/rwlatch.h"
+#include "storage/crc32c.h"
+
+/**
+ @brief 存储层每个Page的id的声明
+ */
+struct PageId {
+    int fd;  //  Page所在的磁盘文件开启后的文件描述符, 来定位打开的文件在内存中的位置
+    page_id_t page_no = INVALID_PAGE_ID;
+
+    friend bool operator==(const PageId &x, const PageId &y) { return x.fd == y.fd && x.page_no == y.page_no; }
+};
+
+// PageId的自定义哈希算法, 用于构建unordered_map<PageId, frame_id_t, PageIdHash>以及缓冲池的页表
+// 把fd和page_no拼成64位整数后做一次murmur3 fmix64混合，高位和低位都分布均匀
+struct PageIdHash {
+    size_t operator()(const PageId &x) const {
+        uint64_t h = (static_cast<uint64_t>(static_cast<uint32_t>(x.fd)) << 32) | static_cast<uint32_t>(x.page_no);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+};
+
+/**
+ @brief Page类声明, Page是rucbase数据块的单位.
+ @note Page是负责数据操作Record模块的操作对象.
+ @note Page对象在磁盘上有文件存储, 若在Buffer中则有帧偏移, 并非特指Buffer或Disk上的数据
+ */
+class Page {
+    friend class BufferPoolManager;
+
+   public:
+    /** Constructor. 数据区由缓冲池的FrameArena分配(已清零)，构造后由BufferPoolManager设置data_ */
+    Page() = default;
+
+    /** Default destructor. */
+    ~Page() = default;
+
+    PageId GetPageId() const { return id_; }
+
+    /** @return the actual data contained within this page */
+    inline char *GetData() { return data_; }
+
+    bool IsDirty() const { return is_dirty_; }
+
+    /** Acquire the page write latch. 持有写锁期间页面版本号处于"正在修改"状态 */
+    inline void WLatch() {
+        rwlatch_.WLock();
+        BeginWrite();
+    }
+
+    /** Release the page write latch. */
+    inline void WUnlatch() {
+        EndWrite();
+        rwlatch_.WUnlock();
+    }
+
+    /** Acquire the page read latch. */
+    inline void RLatch() { rwlatch_.RLock(); }
+
+    /** Release the page read latch. */
+    inline void RUnlatch() { rwlatch_.RUnlock(); }
+
+    /**
+     * @brief 乐观读：读取页面之前记录版本号
+     * @return 有写者正在修改页面时返回false，调用者应当重试
+     */
+    inline bool ReadVersion(uint64_t *version) const {
+        *version = version_.load(std::memory_order_acquire);
+        return (*version & VERSION_WRITER_MASK) == 0;
+    }
+
+    /**
+     * @brief 乐观读：读取页面之后检查版本号，不一致说明读取期间页面被修改过，读到的数据必须丢弃
+     */
+    inline bool ValidateVersion(uint64_t version) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return version_.load(std::memory_order_relaxed) == version;
+    }
+
+    /**
+     * @brief 标记页面开始/结束修改，不获取页面锁。WLatch/WUnlatch会调用它们；
+     * 已经通过更高层的锁(如B+树的root_latch_)与其他写者互斥的调用者可以直接调用，允许嵌套
+     */
+    inline void BeginWrite() { version_.fetch_add(1); }
+
+    inline void EndWrite() { version_.fetch_add(VERSION_UNIT - 1, std::memory_order_release); }
+
+    static constexpr size_t OFFSET_PAGE_START = 0;
+    static constexpr size_t OFFSET_LSN = 0;
+    static constexpr size_t OFFSET_CHECKSUM = 4;  // CRC32C校验和，紧跟在LSN之后，只在带校验和的文件中存在
+    static constexpr size_t OFFSET_PAGE_HDR = 4;  // 不带校验和的页面(索引文件、旧的记录文件)的页面头部从这里开始
+    static constexpr size_t OFFSET_PAGE_HDR_CHECKSUM = OFFSET_CHECKSUM + sizeof(uint32_t);  // 带校验和的页面头部后移4字节
+
+    inline lsn_t GetPageLsn() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN) ; }
+
+    inline void SetPageLsn(lsn_t page_lsn) { memcpy(GetData() + OFFSET_LSN, &page_lsn, sizeof(lsn_t)); }
+
+    /**
+     * @brief 页面数据的CRC32C，覆盖除校验和字段以外的整个页面
+     */
+    static uint32_t ComputeChecksum(const char *data) {
+        uint32_t crc = Crc32c(data, OFFSET_CHECKSUM);
+        return Crc32c(data + OFFSET_CHECKSUM + sizeof(uint32_t), PAGE_SIZE - OFFSET_CHECKSUM - sizeof(uint32_t), crc);
+    }
+
+    /** @brief 写回前把校验和填入页面 */
+    static void SetChecksum(char *data) {
+        uint32_t checksum = ComputeChecksum(data);
+        memcpy(data + OFFSET_CHECKSUM, &checksum, sizeof(checksum));
+    }
+
+    /**
+     * @brief 读入后校验页面，校验和不一致说明页面只写了一部分(torn write)或已损坏
+     * @note 全0的页面是分配后从未写回过的页面(如fallocate预留的空间)，视为有效
+     */
+    static bool VerifyChecksum(const char *data) {
+        uint32_t stored;
+        memcpy(&stored, data + OFFSET_CHECKSUM, sizeof(stored));
+        if (stored == ComputeChecksum(data)) {
+            return true;
+        }
+        return stored == 0 && data[0] == 0 && memcmp(data, data + 1, PAGE_SIZE - 1) == 0;
+    }
+
+   private:
+    void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }  // 将data_的PAGE_SIZE个字节填充为0
+
+    /** page的唯一标识符 */
+    PageId id_;
+
+    /** The actual data that is stored within a page.
+     *  该页面在bufferPool中的偏移地址，指向FrameArena中该帧的数据区；Page对象本身只保存元数据
+     */
+    char *data_ = nullptr;
+
+    /** 脏页判断 */
+    std::atomic<bool> is_dirty_{false};
+
+    /** The pin count of this page.
+     *  缓冲池命中时无锁地CAS增加；-1表示帧空闲或正在被淘汰，此时不能被固定 */
+    std::atomic<int> pin_count_{0};
+
+    /** 帧正在进行磁盘I/O(写回旧页面或读入新页面)，此时data_无效，其他线程需等待I/O完成 */
+    std::atomic<bool> io_in_progress_{false};
+
+    /** 页面最近一次被FetchPage/NewPage访问时缓冲池的访问纪元，转储热页列表时按它从新到旧排序 */
+    std::atomic<uint32_t> access_epoch_{0};
+
+    /** 乐观读的版本号：低8位是正在修改页面的写者个数(可嵌套)，每完成一次修改高位加1 */
+    static constexpr uint64_t VERSION_WRITER_MASK = 0xff;
+    static constexpr uint64_t VERSION_UNIT = VERSION_WRITER_MASK + 1;
+    std::atomic<uint64_t> version_{0};
+
+    /** Page latch. */
+    ReaderWriterLatch rwlatch_;
+};
\ No newline at end of file
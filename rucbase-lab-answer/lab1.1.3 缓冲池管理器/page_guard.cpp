@@ -0,0 +1,74 @@
+#include "page_guard.h"
+
+#include <utility>
+
+#include "buffer_pool_manager.h"
+
+BasicPageGuard::BasicPageGuard(BasicPageGuard &&that) noexcept
+    : bpm_(that.bpm_), page_(that.page_), is_dirty_(that.is_dirty_) {
+    that.bpm_ = nullptr;
+    that.page_ = nullptr;
+    that.is_dirty_ = false;
+}
+
+BasicPageGuard &BasicPageGuard::operator=(BasicPageGuard &&that) noexcept {
+    if (this != &that) {
+        Drop();
+        std::swap(bpm_, that.bpm_);
+        std::swap(page_, that.page_);
+        std::swap(is_dirty_, that.is_dirty_);
+    }
+    return *this;
+}
+
+void BasicPageGuard::Drop() {
+    if (page_ != nullptr) {
+        bpm_->UnpinPage(page_->GetPageId(), is_dirty_);
+    }
+    bpm_ = nullptr;
+    page_ = nullptr;
+    is_dirty_ = false;
+}
+
+ReadPageGuard::ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {
+    if (page != nullptr) {
+        page->RLatch();
+    }
+}
+
+ReadPageGuard &ReadPageGuard::operator=(ReadPageGuard &&that) noexcept {
+    if (this != &that) {
+        Drop();
+        guard_ = std::move(that.guard_);
+    }
+    return *this;
+}
+
+void ReadPageGuard::Drop() {
+    if (guard_.page_ != nullptr) {
+        guard_.page_->RUnlatch();
+    }
+    guard_.Drop();
+}
+
+WritePageGuard::WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {
+    if (page != nullptr) {
+        page->WLatch();
+        guard_.is_dirty_ = true;  // 持有写锁即视为会修改页面
+    }
+}
+
+WritePageGuard &WritePageGuard::operator=(WritePageGuard &&that) noexcept {
+    if (this != &that) {
+        Drop();
+        guard_ = std::move(that.guard_);
+    }
+    return *this;
+}
+
+void WritePageGuard::Drop() {
+    if (guard_.page_ != nullptr) {
+        guard_.page_->WUnlatch();
+    }
+    guard_.Drop();
+}
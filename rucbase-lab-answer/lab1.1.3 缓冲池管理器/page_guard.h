@@ -0,0 +1,189 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// page_guard.h
+//
+// Identification: src/storage/page_guard.h
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "page.h"
+
+class BufferPoolManager;
+
+/**
+ * @brief 页面固定的RAII封装：持有一次对页面的固定，析构(或Drop)时调用UnpinPage，只能移动不能复制
+ * @note GetData()直接返回缓冲池帧中的数据，不复制页面；通过GetDataMut()/AsMut()修改页面后，解除固定时会把页面置脏
+ */
+class BasicPageGuard {
+   public:
+    BasicPageGuard() = default;
+
+    BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+    BasicPageGuard(const BasicPageGuard &) = delete;
+    BasicPageGuard &operator=(const BasicPageGuard &) = delete;
+
+    BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+    /** @brief 先释放当前持有的页面，再接管that的页面 */
+    BasicPageGuard &operator=(BasicPageGuard &&that) noexcept;
+
+    ~BasicPageGuard() { Drop(); }
+
+    /** @brief 提前解除固定，之后guard为空 */
+    void Drop();
+
+    /** @return 页面为空(缓冲池没有可用的帧，或者guard已被移动/释放)时返回nullptr */
+    Page *GetPage() const { return page_; }
+
+    PageId GetPageId() const { return page_->GetPageId(); }
+
+    const char *GetData() const { return page_->GetData(); }
+
+    char *GetDataMut() {
+        is_dirty_ = true;
+        return page_->GetData();
+    }
+
+    template <class T>
+    const T *As() const {
+        return reinterpret_cast<const T *>(GetData());
+    }
+
+    template <class T>
+    T *AsMut() {
+        return reinterpret_cast<T *>(GetDataMut());
+    }
+
+    /** @brief 标记页面已被修改，解除固定时置脏 */
+    void SetDirty() { is_dirty_ = true; }
+
+   private:
+    friend class ReadPageGuard;
+    friend class WritePageGuard;
+
+    BufferPoolManager *bpm_ = nullptr;
+    Page *page_ = nullptr;
+    bool is_dirty_ = false;
+};
+
+/**
+ * @brief 持有页面读锁和一次固定：构造时页面已被固定并加读锁，析构时先释放读锁再解除固定
+ */
+class ReadPageGuard {
+   public:
+    ReadPageGuard() = default;
+
+    /** @param page 已被固定的页面，为nullptr时guard为空 */
+    ReadPageGuard(BufferPoolManager *bpm, Page *page);
+
+    ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+    ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+
+    ~ReadPageGuard() { Drop(); }
+
+    void Drop();
+
+    Page *GetPage() const { return guard_.GetPage(); }
+
+    PageId GetPageId() const { return guard_.GetPageId(); }
+
+    const char *GetData() const { return guard_.GetData(); }
+
+    template <class T>
+    const T *As() const {
+        return guard_.As<T>();
+    }
+
+   private:
+    BasicPageGuard guard_;
+};
+
+/**
+ * @brief 持有页面写锁和一次固定：构造时页面已被固定并加写锁，析构时先释放写锁，再以脏页解除固定
+ */
+class WritePageGuard {
+   public:
+    WritePageGuard() = default;
+
+    /** @param page 已被固定的页面，为nullptr时guard为空 */
+    WritePageGuard(BufferPoolManager *bpm, Page *page);
+
+    WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+    WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+
+    ~WritePageGuard() { Drop(); }
+
+    void Drop();
+
+    Page *GetPage() const { return guard_.GetPage(); }
+
+    PageId GetPageId() const { return guard_.GetPageId(); }
+
+    const char *GetData() const { return guard_.GetData(); }
+
+    char *GetDataMut() { return guard_.GetDataMut(); }
+
+    template <class T>
+    const T *As() const {
+        return guard_.As<T>();
+    }
+
+    template <class T>
+    T *AsMut() {
+        return guard_.AsMut<T>();
+    }
+
+   private:
+    BasicPageGuard guard_;
+};
+
+/**
+ * @brief 乐观读的页面guard：只持有一次固定、不加页面锁。读取页面之前调用ReadVersion()记录版本号，
+ * 读取之后调用Validate()检查期间页面是否被写者修改过，读者之间不会互相争用页面锁
+ * @note Validate()成功之前读到的数据可能不一致，只能复制出来，不能据此修改页面或越界访问
+ */
+class OptimisticPageGuard {
+   public:
+    OptimisticPageGuard() = default;
+
+    /** @param page 已被固定的页面，为nullptr时guard为空 */
+    OptimisticPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+    OptimisticPageGuard(OptimisticPageGuard &&that) noexcept = default;
+
+    OptimisticPageGuard &operator=(OptimisticPageGuard &&that) noexcept = default;
+
+    void Drop() { guard_.Drop(); }
+
+    /** @return 有写者正在修改页面时返回false，调用者应当重试 */
+    bool ReadVersion() { return guard_.GetPage()->ReadVersion(&version_); }
+
+    /** @return 自上次ReadVersion()以来页面没有被修改过 */
+    bool Validate() const { return guard_.GetPage()->ValidateVersion(version_); }
+
+    Page *GetPage() const { return guard_.GetPage(); }
+
+    PageId GetPageId() const { return guard_.GetPageId(); }
+
+    const char *GetData() const { return guard_.GetData(); }
+
+    template <class T>
+    const T *As() const {
+        return guard_.As<T>();
+    }
+
+   private:
+    BasicPageGuard guard_;
+    uint64_t version_ = 0;
+};
@@ -0,0 +1,117 @@
+#include "page_table.h"
+
+#include <cassert>
+
+PageTable::PageTable(size_t capacity) {
+    // 装载因子不超过1/2，保证探测序列很短
+    num_buckets_ = 2;
+    int bits = 1;
+    while (num_buckets_ * SLOTS_PER_BUCKET < capacity * 2) {
+        num_buckets_ <<= 1;
+        bits++;
+    }
+    mask_ = num_buckets_ - 1;
+    shift_ = 64 - bits;
+    buckets_ = std::make_unique<Bucket[]>(num_buckets_);
+}
+
+void PageTable::BeginWrite(Bucket &bucket) {
+    bucket.version_.store(bucket.version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void PageTable::EndWrite(Bucket &bucket) {
+    bucket.version_.store(bucket.version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+bool PageTable::Find(const PageId &page_id, frame_id_t *frame_id) const {
+    uint64_t key = MakeKey(page_id);
+    size_t index = HomeBucket(page_id);
+    for (size_t probes = 0; probes < num_buckets_; probes++) {
+        const Bucket &bucket = buckets_[index];
+        bool found;
+        frame_id_t frame = INVALID_FRAME_ID;
+        uint32_t overflow;
+        while (true) {
+            uint32_t version = bucket.version_.load(std::memory_order_acquire);
+            if (version & 1) {  // 写者正在修改该桶
+                continue;
+            }
+            found = false;
+            for (int i = 0; i < SLOTS_PER_BUCKET; i++) {
+                if (bucket.keys_[i].load(std::memory_order_relaxed) == key) {
+                    frame = bucket.frames_[i].load(std::memory_order_relaxed);
+                    found = true;
+                    break;
+                }
+            }
+            overflow = bucket.overflow_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (bucket.version_.load(std::memory_order_relaxed) == version) {
+                break;
+            }
+        }
+        if (found) {
+            *frame_id = frame;
+            return true;
+        }
+        if (overflow == 0) {  // 没有元素越过本桶，key不可能在后面的桶中
+            return false;
+        }
+        index = NextBucket(index);
+    }
+    return false;
+}
+
+void PageTable::Insert(const PageId &page_id, frame_id_t frame_id) {
+    uint64_t key = MakeKey(page_id);
+    size_t index = HomeBucket(page_id);
+    for (size_t probes = 0; probes < num_buckets_; probes++) {
+        Bucket &bucket = buckets_[index];
+        for (int i = 0; i < SLOTS_PER_BUCKET; i++) {
+            if (bucket.keys_[i].load(std::memory_order_relaxed) == EMPTY_KEY) {
+                BeginWrite(bucket);
+                bucket.frames_[i].store(frame_id, std::memory_order_relaxed);
+                bucket.keys_[i].store(key, std::memory_order_relaxed);
+                EndWrite(bucket);
+                return;
+            }
+        }
+        // 本桶已满，元素存放到后面的桶中，记录在本桶的overflow_上
+        BeginWrite(bucket);
+        bucket.overflow_.store(bucket.overflow_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        EndWrite(bucket);
+        index = NextBucket(index);
+    }
+    assert(false && "page table is full");
+}
+
+void PageTable::Erase(const PageId &page_id) {
+    uint64_t key = MakeKey(page_id);
+    size_t home = HomeBucket(page_id);
+    size_t index = home;
+    for (size_t probes = 0; probes < num_buckets_; probes++) {
+        Bucket &bucket = buckets_[index];
+        for (int i = 0; i < SLOTS_PER_BUCKET; i++) {
+            if (bucket.keys_[i].load(std::memory_order_relaxed) != key) {
+                continue;
+            }
+            BeginWrite(bucket);
+            bucket.keys_[i].store(EMPTY_KEY, std::memory_order_relaxed);
+            bucket.frames_[i].store(INVALID_FRAME_ID, std::memory_order_relaxed);
+            EndWrite(bucket);
+            // 撤销插入时在探测路径上各桶留下的overflow_计数
+            for (size_t j = home; j != index; j = NextBucket(j)) {
+                Bucket &passed = buckets_[j];
+                BeginWrite(passed);
+                passed.overflow_.store(passed.overflow_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+                EndWrite(passed);
+            }
+            return;
+        }
+        if (bucket.overflow_.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        index = NextBucket(index);
+    }
+}
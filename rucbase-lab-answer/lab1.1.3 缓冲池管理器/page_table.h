@@ -0,0 +1,94 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// page_table.h
+//
+// Identification: src/storage/page_table.h
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "common/config.h"
+#include "page.h"
+
+/**
+ * @brief 缓冲池的页表：PageId -> frame_id_t 的开放寻址哈希表
+ * 每个桶占一个cache line，存放SLOTS_PER_BUCKET个键值对；桶按线性探测组成探测序列，
+ * 桶上的overflow_记录"主桶在它之前、但存放在它之后"的元素个数，为0时查找可以提前结束，因此删除不需要墓碑
+ *
+ * @note 写操作(Insert/Erase)由调用者串行化(持有分片latch)；Find无锁，通过每个桶的版本号(seqlock)检测并发修改后重试。
+ * Find的结果只是提示：调用者必须在固定帧之后再检查帧中的page_id，查找失败时需要持有latch重新查找
+ */
+class PageTable {
+   public:
+    /**
+     * @param capacity 页表最多需要容纳的元素个数(分片的帧数)，构造时一次性分配所有桶，插入不再申请内存
+     */
+    explicit PageTable(size_t capacity);
+
+    PageTable(const PageTable &) = delete;
+    PageTable &operator=(const PageTable &) = delete;
+
+    /**
+     * @brief 无锁查找page_id所在的帧
+     * @param[out] frame_id 找到时为page_id所在的帧
+     * @return 是否找到
+     */
+    bool Find(const PageId &page_id, frame_id_t *frame_id) const;
+
+    /**
+     * @brief 插入page_id -> frame_id，page_id必须不在表中；调用者需持有写锁
+     */
+    void Insert(const PageId &page_id, frame_id_t frame_id);
+
+    /**
+     * @brief 删除page_id，不存在时什么都不做；调用者需持有写锁
+     */
+    void Erase(const PageId &page_id);
+
+   private:
+    static constexpr int SLOTS_PER_BUCKET = 4;
+    static constexpr uint64_t EMPTY_KEY = UINT64_MAX;
+
+    struct alignas(64) Bucket {
+        std::atomic<uint32_t> version_{0};   // 奇数表示正在被修改
+        std::atomic<uint32_t> overflow_{0};  // 探测时越过本桶继续向后存放的元素个数
+        std::atomic<uint64_t> keys_[SLOTS_PER_BUCKET];
+        std::atomic<frame_id_t> frames_[SLOTS_PER_BUCKET];
+
+        Bucket() {
+            for (int i = 0; i < SLOTS_PER_BUCKET; i++) {
+                keys_[i].store(EMPTY_KEY, std::memory_order_relaxed);
+                frames_[i].store(INVALID_FRAME_ID, std::memory_order_relaxed);
+            }
+        }
+    };
+    static_assert(sizeof(Bucket) == 64, "a page table bucket should fill exactly one cache line");
+
+    static uint64_t MakeKey(const PageId &page_id) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(page_id.fd)) << 32) | static_cast<uint32_t>(page_id.page_no);
+    }
+
+    /** @brief 用哈希值的高位选择主桶，低位用于选择缓冲池分片，两者互不相关 */
+    size_t HomeBucket(const PageId &page_id) const { return PageIdHash()(page_id) >> shift_; }
+
+    size_t NextBucket(size_t bucket) const { return (bucket + 1) & mask_; }
+
+    /** @brief 写者开始/结束修改一个桶 */
+    static void BeginWrite(Bucket &bucket);
+    static void EndWrite(Bucket &bucket);
+
+    size_t num_buckets_;
+    size_t mask_;
+    int shift_;
+    std::unique_ptr<Bucket[]> buckets_;
+};
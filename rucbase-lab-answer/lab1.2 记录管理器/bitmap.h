@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>  // for AVX2 intrinsics
+#endif
+
+static constexpr int BITMAP_WIDTH = 8;
+static constexpr unsigned BITMAP_HIGHEST_BIT = 0x80u;  // 128 (2^7)
+static constexpr int BITMAP_PROBE_BITS = 8;            // next_bit按字查找之前逐位判断的位数
+
+/**
+ * @brief 页面中slot的位图，第pos位是第pos/8个字节中从最高位数起的第pos%8位(磁盘上的位序)
+ * @note 查找按64位字进行：每次读入8个字节并按大端序拼成一个字，第pos位正好是字中从最高位数起的第pos%64位，
+ * 用count-leading-zeros一次找到字中的第一个目标位；较长的位图在支持AVX2的CPU上先按32字节整块跳过不含目标位的部分
+ */
+class Bitmap {
+   public:
+    // 从地址bm开始的size个字节全部置0
+    static void init(char *bm, int size) { memset(bm, 0, size); }
+
+    // pos位 置1
+    static void set(char *bm, int pos) { bm[get_bucket(pos)] |= get_bit(pos); }
+
+    // pos位 置0
+    static void reset(char *bm, int pos) { bm[get_bucket(pos)] &= static_cast<char>(~get_bit(pos)); }
+
+    // 如果pos位是1，则返回true
+    static bool is_set(const char *bm, int pos) { return (bm[get_bucket(pos)] & get_bit(pos)) != 0; }
+
+    /**
+     * @brief 找下一个为0 or 1的位
+     * @param bit false表示要找下一个为0的位，true表示要找下一个为1的位
+     * @param bm 要找的起始地址为bm
+     * @param max_n 要找的从起始地址开始的偏移为[curr+1,max_n)
+     * @param curr 要找的从起始地址开始的偏移为[curr+1,max_n)
+     * @return 找到了就返回偏移位置，没找到就返回max_n
+     * @note 只读取位图的前(max_n+7)/8个字节
+     */
+    static int next_bit(bool bit, const char *bm, int max_n, int curr) {
+        int pos = curr + 1;
+        if (pos >= max_n) {
+            return max_n;
+        }
+        // 目标位较密集时(满页上扫描、插入)往往就在后面几位：逐位判断只是几次可预测的分支，
+        // 避免按字查找每次调用都有一条load-bswap-clz的数据依赖链；前BITMAP_PROBE_BITS位中没有时再按字查找
+        int probe_end = std::min(pos + BITMAP_PROBE_BITS, max_n);
+        for (; pos < probe_end; pos++) {
+            if (is_set(bm, pos) == bit) {
+                return pos;
+            }
+        }
+        return pos < max_n ? next_bit_in_words(bit, bm, max_n, pos) : max_n;
+    }
+
+    // 找第一个为0 or 1的位
+    static int first_bit(bool bit, const char *bm, int max_n) { return next_bit(bit, bm, max_n, -1); }
+
+    /**
+     * @brief 统计[0, max_n)中为0 or 1的位数，按64位字popcount
+     */
+    static int count(bool bit, const char *bm, int max_n) {
+        int num_bytes = (max_n + BITMAP_WIDTH - 1) / BITMAP_WIDTH;
+        int ones = 0;
+        for (int byte = 0; byte < num_bytes; byte += sizeof(uint64_t)) {
+            uint64_t word = load_word(bm, byte, num_bytes);
+            int end = max_n - byte * BITMAP_WIDTH;  // 本字中属于位图的位数
+            if (end < 64) {
+                word &= ~(~0ULL >> end);
+            }
+            ones += __builtin_popcountll(word);
+        }
+        return bit ? ones : max_n - ones;
+    }
+
+    // for example:
+    // rid_.slot_no = Bitmap::next_bit(true, page_handle.bitmap, file_handle_->file_hdr_.num_records_per_page,
+    // rid_.slot_no); int slot_no = Bitmap::first_bit(false, page_handle.bitmap, file_hdr_.num_records_per_page);
+
+   private:
+    static int get_bucket(int pos) { return pos / BITMAP_WIDTH; }
+
+    static char get_bit(int pos) { return BITMAP_HIGHEST_BIT >> static_cast<char>(pos % BITMAP_WIDTH); }
+
+    /**
+     * @brief 从pos开始按64位字查找
+     */
+    __attribute__((noinline)) static int next_bit_in_words(bool bit, const char *bm, int max_n, int pos) {
+        int num_bytes = (max_n + BITMAP_WIDTH - 1) / BITMAP_WIDTH;
+        uint64_t flip = bit ? 0 : ~0ULL;  // 找0时取反，统一成找1
+        int byte = get_bucket(pos);
+        uint64_t word = (load_word(bm, byte, num_bytes) ^ flip) & (~0ULL >> (pos % BITMAP_WIDTH));
+        while (word == 0) {
+            byte += sizeof(uint64_t);
+            if (byte >= num_bytes) {
+                return max_n;
+            }
+#if defined(__x86_64__)
+            if (num_bytes - byte >= AVX2_MIN_BYTES && has_avx2()) {
+                byte = skip_chunks_avx2(bit, bm, byte, num_bytes);
+                if (byte >= num_bytes) {
+                    return max_n;
+                }
+            }
+#endif
+            word = load_word(bm, byte, num_bytes) ^ flip;
+        }
+        // 末尾不足8字节时补的0在找0时会被取反成1，超出max_n的结果一律视为没找到
+        return std::min(byte * BITMAP_WIDTH + __builtin_clzll(word), max_n);
+    }
+
+    /**
+     * @brief 读入从第byte个字节开始的8个字节，按大端序拼成一个字；超出num_bytes的字节补0
+     */
+    static uint64_t load_word(const char *bm, int byte, int num_bytes) {
+        uint64_t word = 0;
+        if (num_bytes - byte >= static_cast<int>(sizeof(word))) {
+            memcpy(&word, bm + byte, sizeof(word));
+        } else {
+            memcpy(&word, bm + byte, num_bytes - byte);
+        }
+        return __builtin_bswap64(word);
+    }
+
+#if defined(__x86_64__)
+    /** 剩余的位图不少于这么多字节时才使用AVX2整块跳过 */
+    static constexpr int AVX2_MIN_BYTES = 64;
+
+    static bool has_avx2() {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+
+    /**
+     * @brief 从第byte个字节开始按32字节整块跳过不含目标位的部分(找1时全0的块，找0时全1的块)
+     * @return 第一个可能含有目标位的字节，不足32字节的末尾部分留给调用者按字查找
+     */
+    __attribute__((target("avx2"))) static int skip_chunks_avx2(bool bit, const char *bm, int byte, int num_bytes) {
+        const __m256i ones = _mm256_set1_epi8(-1);
+        for (; byte + 32 <= num_bytes; byte += 32) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bm + byte));
+            bool skip = bit ? _mm256_testz_si256(chunk, chunk) : _mm256_testc_si256(chunk, ones);
+            if (!skip) {
+                break;
+            }
+        }
+        return byte;
+    }
+#endif
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+
+#include "common/macros.h"
+#include "defs.h"
+#include "storage/buffer_pool_manager.h"
+
+constexpr int RM_NO_PAGE = -1;
+constexpr int RM_FILE_HDR_PAGE = 0;
+constexpr int RM_FIRST_RECORD_PAGE = 1;
+constexpr int RM_MAX_RECORD_SIZE = 512;
+
+// 记录文件的页面布局，建表时按表选择，保存在file_hdr中
+constexpr int RM_LAYOUT_FIXED = 0;    // 定长：每条记录占record_size字节的slot，用bitmap标记
+constexpr int RM_LAYOUT_SLOTTED = 1;  // 分槽：槽目录+变长记录，record_size是记录的最大长度
+
+// 分槽布局中页面的类型
+constexpr int RM_PAGE_SLOTTED = 1;   // 存放记录的分槽页面
+constexpr int RM_PAGE_OVERFLOW = 2;  // 溢出页面，存放较长记录的一段，扫描时跳过
+
+constexpr int RM_SLOTTED_MAX_INLINE_SIZE = PAGE_SIZE / 4;  // 超过这个长度的记录放在溢出页面中，保证每页能放下多条记录
+constexpr int RM_SLOTTED_MIN_FREE_BYTES = PAGE_SIZE / 16;  // 空闲空间不少于这么多字节的分槽页面挂在空闲页链表上
+
+// record file header（RmManager::create_file函数初始化，并写入磁盘文件中的第0页）
+struct RmFileHdr {
+    int record_size;  // 元组大小（长度不固定，由上层进行初始化）
+    // std::atomic<page_id_t> num_pages;
+    int num_pages;             // 文件中当前分配的page个数（初始化为1）
+    int num_records_per_page;  // 每个page最多能存储的元组个数
+    int first_free_page_no;    // 文件中当前第一个可用的page no（初始化为-1）
+    int bitmap_size;           // bitmap大小
+    int layout;                // 页面布局RM_LAYOUT_FIXED/RM_LAYOUT_SLOTTED（旧文件中该字段为0，即定长布局）
+    int first_free_overflow_page_no;  // 分槽布局中已释放、可复用的第一个溢出页面（初始化为-1）
+    int page_checksum;                // 页面是否带CRC32C校验和（旧文件中该字段为0，即不带）
+
+    // 数据页中页面头部(RmPageHdr/RmSlottedPageHdr)的起始偏移；分槽布局总是留出校验和字段
+    int page_hdr_offset() const {
+        return static_cast<int>(page_checksum || layout == RM_LAYOUT_SLOTTED ? Page::OFFSET_PAGE_HDR_CHECKSUM
+                                                                             : Page::OFFSET_PAGE_HDR);
+    }
+};
+
+// 增加分槽布局之前的文件头只有layout之前的字段，没有数据页的旧文件只有这么长
+constexpr int RM_LEGACY_FILE_HDR_SIZE = static_cast<int>(offsetof(RmFileHdr, layout));
+
+// record page header（RmFileHandle::create_page函数进行初始化）
+struct RmPageHdr {
+    int next_free_page_no;  // 当前page满了之后，下一个可用的page no（初始化为-1）
+    int num_records;        // 当前page中当前分配的record个数（初始化为0）
+};
+
+// 分槽页面的页头，前两个字段与RmPageHdr相同
+struct RmSlottedPageHdr {
+    int next_free_page_no;  // 空闲页链表中的下一页
+    int num_records;        // 页面中有效记录的个数
+    int page_type;          // RM_PAGE_SLOTTED
+    int num_slots;          // 槽目录的长度（含已删除记录留下的空槽）
+    int data_begin;         // 记录数据区的起始偏移，数据区从页尾向前增长
+    int free_bytes;         // 空闲字节数，包括槽目录与数据区之间的连续空间和数据区中删除、缩短记录留下的空洞
+    int in_free_list;       // 页面是否挂在空闲页链表上
+};
+
+// 溢出页面的页头，page_type与RmSlottedPageHdr的位置相同
+struct RmOverflowPageHdr {
+    int next_page_no;  // 同一条记录的下一个溢出页面，或已释放溢出页面链表中的下一页
+    int data_size;     // 本页中的数据字节数
+    int page_type;     // RM_PAGE_OVERFLOW
+};
+
+// 槽目录中的一项：记录在页内的偏移和长度，offset为0表示空槽
+struct RmSlot {
+    uint16_t offset;
+    uint16_t size;  // 最高位为RM_SLOT_OVERFLOW时，槽中存放的是RmOverflowRef
+};
+
+constexpr uint16_t RM_SLOT_OVERFLOW = 0x8000;
+
+// 存放在溢出页面中的记录在分槽页面中留下的引用
+struct RmOverflowRef {
+    int size;                // 记录的长度
+    page_id_t first_page_no; // 第一个溢出页面
+};
+
+// 类似于Tuple
+struct RmRecord {
+    char *data;  // data初始化分配size个字节的空间
+    int size;    // size = RmFileHdr的record_size
+    bool allocated_ = false;
+
+    // DISALLOW_COPY(RmRecord);
+    // RmRecord(const RmRecord &other) = delete;
+    // RmRecord &operator=(const RmRecord &other) = delete;
+
+    RmRecord() = default;
+
+    RmRecord(const RmRecord &other) {
+        size = other.size;
+        data = new char[size];
+        memcpy(data, other.data, size);
+        allocated_ = true;
+    };
+
+    RmRecord &operator=(const RmRecord &other) {
+        size = other.size;
+        data = new char[size];
+        memcpy(data, other.data, size);
+        allocated_ = true;
+        return *this;
+    };
+
+    RmRecord(int size_) {
+        size = size_;
+        data = new char[size_];
+        allocated_ = true;
+    }
+
+    RmRecord(int size_, char *data_) {
+        size = size_;
+        data = new char[size_];
+        memcpy(data, data_, size_);
+        allocated_ = true;
+    }
+
+    void SetData(char *data_) {
+        memcpy(data, data_, size);
+    }
+
+    void Deserialize(const char *data_) {
+        size = *reinterpret_cast<const int *>(data_);
+        delete[] data;
+        data = new char[size];
+        memcpy(data, data_ + sizeof(int), size);
+    }
+
+    ~RmRecord() {
+        if(allocated_) {
+            delete[] data;
+        }
+        allocated_ = false;
+        data = nullptr;
+    }
+};
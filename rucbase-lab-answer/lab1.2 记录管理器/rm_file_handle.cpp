@@ -1,228 +1,704 @@
-#include "rm_file_handle.h"
-
-/**
- * @brief 由Rid得到指向RmRecord的指针
- *
- * @param rid 指定记录所在的位置
- * @return std::unique_ptr<RmRecord>
- */
-std::unique_ptr<RmRecord> RmFileHandle::get_record(const Rid &rid, Context *context) const {
-    // Todo:
-    // 1. 获取指定记录所在的page handle
-    // 2. 初始化一个指向RmRecord的指针（赋值其内部的data和size）
-
-    int page_no = rid.page_no;
-    int slot_no = rid.slot_no; //获取记录所在页面以及记录所在slot
-
-    RmPageHandle rph = fetch_page_handle(page_no); //获取对用页面号所在的页面管理 have question
-
-    //std::cout << "get record : " << __LINE__ << std::endl;
-
-    //新建一个指向rmrecord的指针
-    auto rr = std::make_unique<RmRecord>(file_hdr_.record_size);
-    rr->size = file_hdr_.record_size; //赋值记录大小
-    char *slot = rph.get_slot(slot_no);
-    memcpy(rr->data, slot, rr->size); //复制记录数据
-    
-    //std::cout << "get record : " << __LINE__ << std::endl;
-
-    return rr;
-    //return nullptr;
-}
-
-/**
- * @brief 在该记录文件（RmFileHandle）中插入一条记录
- *
- * @param buf 要插入的数据的地址
- * @return Rid 插入记录的位置
- */
-Rid RmFileHandle::insert_record(char *buf, Context *context) { //have question
-    // Todo:
-    // 1. 获取当前未满的page handle
-    // 2. 在page handle中找到空闲slot位置
-    // 3. 将buf复制到空闲slot位置
-    // 4. 更新page_handle.page_hdr中的数据结构
-    // 注意考虑插入一条记录后页面已满的情况，需要更新file_hdr_.first_free_page_no
-
-    //1. 获取当前未满的page handle
-    RmPageHandle rph = create_page_handle();
-    
-    // 2. 在page handle中找到空闲slot位置
-    //怎么找空闲slot？ bitmap 记录了所有slot的情况
-    //每个slot 存储一行记录
-    int bit = Bitmap::first_bit(false, rph.bitmap, rph.file_hdr->num_records_per_page); //获取第一个空闲的slot
-    Bitmap::set(rph.bitmap, bit); //将bit位置1
-
-    // 3. 将buf复制到空闲slot位置
-    std::copy(buf, buf + rph.file_hdr->record_size, rph.get_slot(bit));//将数据插入该slot
-
-    //4. 更新page_handle.page_hdr中的数据结构
-    if( ++ rph.page_hdr->num_records >= rph.file_hdr->num_records_per_page) //插入记录后页面已满
-        file_hdr_.first_free_page_no = rph.page_hdr->next_free_page_no;
-    
-    //RmPageHandle rph = fetch_page_handle(page_no); //获取该页面号的rph  //have question
-
-    //std::cout << __LINE__ << std::endl;
-
-    Rid rid; //返回rid
-    rid.page_no = rph.page->GetPageId().page_no;
-    rid.slot_no = bit;
-    return rid;
-
-    //return Rid{-1, -1};
-}
-
-/**
- * @brief 在该记录文件（RmFileHandle）中删除一条指定位置的记录
- *
- * @param rid 要删除的记录所在的指定位置
- */
-void RmFileHandle::delete_record(const Rid &rid, Context *context) {
-    // Todo:
-    // 1. 获取指定记录所在的page handle
-    // 2. 更新page_handle.page_hdr中的数据结构
-    // 注意考虑删除一条记录后页面未满的情况，需要调用release_page_handle()
-
-    //1. 获取指定记录所在的page handle
-    int page_no = rid.page_no;
-    int slot_no = rid.slot_no;
-    RmPageHandle rph = fetch_page_handle(page_no);
-
-    // 2. 更新page_handle.page_hdr中的数据结构
-    if( -- rph.page_hdr->num_records < file_hdr_.num_records_per_page)
-        release_page_handle(rph);
-    Bitmap::reset(rph.bitmap, slot_no); //重置slot位
-
-}
-
-/**
- * @brief 更新指定位置的记录
- *
- * @param rid 指定位置的记录
- * @param buf 新记录的数据的地址
- */
-void RmFileHandle::update_record(const Rid &rid, char *buf, Context *context) {
-    // Todo:
-    // 1. 获取指定记录所在的page handle
-    // 2. 更新记录
-
-    int page_no = rid.page_no;
-    int slot_no = rid.slot_no;
-    RmPageHandle rph = fetch_page_handle(page_no); //获取指定记录所在的page handle
-    std::copy(buf, buf + rph.file_hdr->record_size, rph.get_slot(slot_no));//更新记录
-}
-
-/** -- 以下为辅助函数 -- */
-/**
- * @brief 获取指定页面编号的page handle
- *
- * @param page_no 要获取的页面编号
- * @return RmPageHandle 返回给上层的page_handle
- * @note pin the page, remember to unpin it outside!
- */
-RmPageHandle RmFileHandle::fetch_page_handle(int page_no) const {
-    // Todo:
-    // 使用缓冲池获取指定页面，并生成page_handle返回给上层
-    // if page_no is invalid, throw PageNotExistError exception
-
-    //使用缓冲池获取指定页面
-    PageId pId;
-    pId.fd = fd_;
-    pId.page_no = page_no;
-    //std::cout << __LINE__ << std::endl;
-
-    Page* p = buffer_pool_manager_->FetchPage(pId); //have question
-
-    if(page_no < file_hdr_.num_pages){ 
-        return RmPageHandle(&file_hdr_, p);
-    }else{
-        throw PageNotExistError("name", page_no); 
-    } 
-    
-    //return RmPageHandle(&file_hdr_, nullptr);
-
-    //pin the page, remember to unpin it outside!  ??????
-}
-
-/**
- * @brief 创建一个新的page handle
- *
- * @return RmPageHandle
- */
-RmPageHandle RmFileHandle::create_new_page_handle() {
-    // Todo:
-    // 1.使用缓冲池来创建一个新page
-    // 2.更新page handle中的相关信息
-    // 3.更新file_hdr_
-    //1.
-    PageId pId;
-    pId.fd = fd_;
-    Page* p = buffer_pool_manager_->NewPage(&pId); //新建page
-    
-    //2.更新page handle中的相关信息
-    //rmpagehandle函数自动设置bitmap 与 slots
-    RmPageHandle rph = RmPageHandle(&file_hdr_, p);//根据新建的page与file_hdr_建立页面管理
-    rph.page_hdr->next_free_page_no = -1;//下一个可用的page no（初始化为-1）
-    rph.page_hdr->num_records = 0; //page中当前分配的record个数（初始化为0）
-    
-    //3.更新file_hdr_
-    file_hdr_.num_pages ++ ;
-    file_hdr_.first_free_page_no = p->GetPageId().page_no;
-    //file_hdr_.
-    return rph;
-}
-
-/**
- * @brief 创建或获取一个空闲的page handle
- *
- * @return RmPageHandle 返回生成的空闲page handle
- * @note pin the page, remember to unpin it outside!
- */
-RmPageHandle RmFileHandle::create_page_handle() {
-    // Todo:
-    // 1. 判断file_hdr_中是否还有空闲页
-    //     1.1 没有空闲页：使用缓冲池来创建一个新page；可直接调用create_new_page_handle()
-    //     1.2 有空闲页：直接获取第一个空闲页
-    // 2. 生成page handle并返回给上层
-
-    //1.判断file_hdr_中是否还有空闲页
-    //怎么判断是否空闲：1.pin_count? 
-    if(file_hdr_.first_free_page_no == -1) //没有空闲页
-        return create_new_page_handle();
-    else return fetch_page_handle(file_hdr_.first_free_page_no); //取该page_on 对应的pagehandl
-}
-
-/**
- * @brief 当page handle中的page从已满变成未满的时候调用
- *
- * @param page_handle
- * @note only used in delete_record()
- */
-void RmFileHandle::release_page_handle(RmPageHandle &page_handle) {
-    // Todo:
-    // 当page从已满变成未满，考虑如何更新：
-    // 1. page_handle.page_hdr->next_free_page_no
-    // 2. file_hdr_.first_free_page_no
-    
-
-    std::swap(page_handle.page_hdr->next_free_page_no, file_hdr_.first_free_page_no);
-    
-}
-
-// used for recovery (lab4)
-void RmFileHandle::insert_record(const Rid &rid, char *buf) {
-    if (rid.page_no < file_hdr_.num_pages) {
-        create_new_page_handle();
-    }
-    RmPageHandle pageHandle = fetch_page_handle(rid.page_no);
-    Bitmap::set(pageHandle.bitmap, rid.slot_no);
-    pageHandle.page_hdr->num_records++;
-    if (pageHandle.page_hdr->num_records == file_hdr_.num_records_per_page) {
-        file_hdr_.first_free_page_no = pageHandle.page_hdr->next_free_page_no;
-    }
-
-    char *slot = pageHandle.get_slot(rid.slot_no);
-    memcpy(slot, buf, file_hdr_.record_size);
-
-    buffer_pool_manager_->UnpinPage(pageHandle.page->GetPageId(), true);
-}
\ No newline at end of file
+#include "rm_file_handle.h"
+
+#include <algorithm>
+
+/**
+ * @brief 由Rid得到指向RmRecord的指针
+ *
+ * @param rid 指定记录所在的位置
+ * @return std::unique_ptr<RmRecord>
+ */
+std::unique_ptr<RmRecord> RmFileHandle::get_record(const Rid &rid, Context *context) const {
+    // Todo:
+    // 1. 获取指定记录所在的page handle
+    // 2. 初始化一个指向RmRecord的指针（赋值其内部的data和size）
+
+    int page_no = rid.page_no;
+    int slot_no = rid.slot_no; //获取记录所在页面以及记录所在slot
+    if(page_no < 0 || page_no >= file_hdr_.num_pages){
+        throw PageNotExistError("name", page_no);
+    }
+    if(is_slotted()){ //分槽页面中记录的位置随整理移动，加读锁复制
+        RmPageHandle rph = fetch_read_page_handle(page_no);
+        RecordView view = slotted_record_view(rph.page->GetData(), rid);
+        return view.to_record();
+    }
+
+    //新建一个指向rmrecord的指针
+    auto rr = std::make_unique<RmRecord>(file_hdr_.record_size);
+    rr->size = file_hdr_.record_size; //赋值记录大小
+
+    //乐观读：只固定页面、不加读锁，复制记录之后检查页面版本号，期间页面被修改过则重新复制
+    OptimisticPageGuard guard = buffer_pool_manager_->FetchPageOptimistic(PageId{fd_, page_no});
+    RmPageHandle rph(&file_hdr_, guard.GetPage());
+    for (int i = 0; i < OPTIMISTIC_READ_RETRIES; i++) {
+        if (!guard.ReadVersion()) {
+            continue;  // 写者正在修改该页面
+        }
+        memcpy(rr->data, rph.get_slot(slot_no), rr->size); //复制记录数据
+        if (guard.Validate()) {
+            return rr;
+        }
+    }
+
+    //写者频繁修改该页面时退回加读锁复制，guard析构时解除固定
+    guard.GetPage()->RLatch();
+    memcpy(rr->data, rph.get_slot(slot_no), rr->size);
+    guard.GetPage()->RUnlatch();
+    return rr;
+    //return nullptr;
+}
+
+/**
+ * @brief 由Rid得到记录的只读视图，不构造RmRecord
+ *
+ * @param rid 指定记录所在的位置
+ * @return RecordView 指向视图自己持有的副本，不持有页面的固定和锁
+ * @note 与RmScan::record()一样，只在复制记录期间加读锁；读锁不会留到调用之外，
+ * 视图存在期间同一线程或其他线程都可以修改该页面(写者优先的页面锁上不会死锁)
+ */
+RecordView RmFileHandle::get_record_view(const Rid &rid, Context *context) const {
+    if(rid.page_no < 0 || rid.page_no >= file_hdr_.num_pages){
+        throw PageNotExistError("name", rid.page_no);
+    }
+    BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(PageId{fd_, rid.page_no}); //只固定页面，返回时解除
+    Page *page = guard.GetPage();
+    page->RLatch();
+    RecordView view;
+    try {
+        if(is_slotted()){
+            view = slotted_record_view(page->GetData(), rid);
+        }else{
+            RmPageHandle rph(&file_hdr_, page);
+            view = RecordView(rph.get_slot(rid.slot_no), file_hdr_.record_size);
+        }
+        if(view.buffer == nullptr){ //指向帧中的记录，释放读锁之前复制出来
+            std::unique_ptr<char[]> buffer(new char[view.size]);
+            memcpy(buffer.get(), view.data, view.size);
+            view = RecordView(std::move(buffer), view.size);
+        }
+    } catch (...) {
+        page->RUnlatch();
+        throw;
+    }
+    page->RUnlatch();
+    return view;
+}
+
+/**
+ * @brief 在该记录文件（RmFileHandle）中插入一条记录
+ *
+ * @param buf 要插入的数据的地址
+ * @return Rid 插入记录的位置
+ */
+Rid RmFileHandle::insert_record(char *buf, Context *context) { //have question
+    // Todo:
+    // 1. 获取当前未满的page handle
+    // 2. 在page handle中找到空闲slot位置
+    // 3. 将buf复制到空闲slot位置
+    // 4. 更新page_handle.page_hdr中的数据结构
+    // 注意考虑插入一条记录后页面已满的情况，需要更新file_hdr_.first_free_page_no
+
+    if(is_slotted()) return insert_slotted_record(buf, file_hdr_.record_size);
+
+    //1. 获取当前未满的page handle
+    RmPageHandle rph = create_page_handle();
+    
+    // 2. 在page handle中找到空闲slot位置
+    //怎么找空闲slot？ bitmap 记录了所有slot的情况
+    //每个slot 存储一行记录
+    int bit = Bitmap::first_bit(false, rph.bitmap, rph.file_hdr->num_records_per_page); //获取第一个空闲的slot
+    Bitmap::set(rph.bitmap, bit); //将bit位置1
+
+    // 3. 将buf复制到空闲slot位置
+    std::copy(buf, buf + rph.file_hdr->record_size, rph.get_slot(bit));//将数据插入该slot
+
+    //4. 更新page_handle.page_hdr中的数据结构
+    if( ++ rph.page_hdr->num_records >= rph.file_hdr->num_records_per_page) //插入记录后页面已满
+        file_hdr_.first_free_page_no = rph.page_hdr->next_free_page_no;
+    
+    //RmPageHandle rph = fetch_page_handle(page_no); //获取该页面号的rph  //have question
+
+    //std::cout << __LINE__ << std::endl;
+
+    Rid rid; //返回rid
+    rid.page_no = rph.page->GetPageId().page_no;
+    rid.slot_no = bit;
+    return rid;
+
+    //return Rid{-1, -1};
+}
+
+/**
+ * @brief 插入一条长度为size的记录
+ *
+ * @param buf 要插入的数据的地址
+ * @param size 记录的长度，定长布局中必须等于record_size，分槽布局中为[1, record_size]
+ * @return Rid 插入记录的位置
+ */
+Rid RmFileHandle::insert_record(const char *buf, int size, Context *context) {
+    check_record_size(size);
+    if(!is_slotted()) return insert_record(const_cast<char *>(buf), context);
+    return insert_slotted_record(buf, size);
+}
+
+/**
+ * @brief 在该记录文件（RmFileHandle）中删除一条指定位置的记录
+ *
+ * @param rid 要删除的记录所在的指定位置
+ */
+void RmFileHandle::delete_record(const Rid &rid, Context *context) {
+    // Todo:
+    // 1. 获取指定记录所在的page handle
+    // 2. 更新page_handle.page_hdr中的数据结构
+    // 注意考虑删除一条记录后页面未满的情况，需要调用release_page_handle()
+
+    //1. 获取指定记录所在的page handle
+    if(is_slotted()) return delete_slotted_record(rid);
+
+    int page_no = rid.page_no;
+    int slot_no = rid.slot_no;
+    RmPageHandle rph = fetch_page_handle(page_no);
+
+    // 2. 更新page_handle.page_hdr中的数据结构
+    //只有删除前页面是满的，才需要把它重新挂到空闲页链表上，否则它已经在链表中
+    if( rph.page_hdr->num_records -- == file_hdr_.num_records_per_page)
+        release_page_handle(rph);
+    Bitmap::reset(rph.bitmap, slot_no); //重置slot位
+
+}
+
+/**
+ * @brief 更新指定位置的记录
+ *
+ * @param rid 指定位置的记录
+ * @param buf 新记录的数据的地址
+ */
+void RmFileHandle::update_record(const Rid &rid, char *buf, Context *context) {
+    // Todo:
+    // 1. 获取指定记录所在的page handle
+    // 2. 更新记录
+
+    if(is_slotted()) return update_slotted_record(rid, buf, file_hdr_.record_size);
+
+    int page_no = rid.page_no;
+    int slot_no = rid.slot_no;
+    RmPageHandle rph = fetch_page_handle(page_no); //获取指定记录所在的page handle
+    std::copy(buf, buf + rph.file_hdr->record_size, rph.get_slot(slot_no));//更新记录
+}
+
+/**
+ * @brief 把指定位置的记录更新为长度为size的新记录
+ *
+ * @param rid 指定位置的记录
+ * @param buf 新记录的数据的地址
+ * @param size 新记录的长度，限制同insert_record
+ */
+void RmFileHandle::update_record(const Rid &rid, const char *buf, int size, Context *context) {
+    check_record_size(size);
+    if(!is_slotted()) return update_record(rid, const_cast<char *>(buf), context);
+    update_slotted_record(rid, buf, size);
+}
+
+/** -- 以下为辅助函数 -- */
+/**
+ * @brief 获取指定页面编号的page handle，用于修改页面
+ *
+ * @param page_no 要获取的页面编号
+ * @return RmPageHandle 返回给上层的page_handle
+ * @note page handle持有页面的固定和写锁，析构时以脏页解除固定
+ */
+RmPageHandle RmFileHandle::fetch_page_handle(int page_no) const {
+    // Todo:
+    // 使用缓冲池获取指定页面，并生成page_handle返回给上层
+    // if page_no is invalid, throw PageNotExistError exception
+
+    //先检查页号，无效页号不能固定页面
+    if(page_no < 0 || page_no >= file_hdr_.num_pages){
+        throw PageNotExistError("name", page_no);
+    }
+    return RmPageHandle(&file_hdr_, buffer_pool_manager_->FetchPageWrite(PageId{fd_, page_no}));
+}
+
+/**
+ * @brief 获取指定页面编号的只读page handle，持有页面的固定和读锁，析构时解除固定
+ */
+RmPageHandle RmFileHandle::fetch_read_page_handle(int page_no) const {
+    if(page_no < 0 || page_no >= file_hdr_.num_pages){
+        throw PageNotExistError("name", page_no);
+    }
+    return RmPageHandle(&file_hdr_, buffer_pool_manager_->FetchPageRead(PageId{fd_, page_no}));
+}
+
+/**
+ * @brief 创建一个新的page handle
+ *
+ * @return RmPageHandle
+ */
+RmPageHandle RmFileHandle::create_new_page_handle() {
+    // Todo:
+    // 1.使用缓冲池来创建一个新page
+    // 2.更新page handle中的相关信息
+    // 3.更新file_hdr_
+    //1.
+    PageId pId;
+    pId.fd = fd_;
+    
+    //2.更新page handle中的相关信息
+    //rmpagehandle函数自动设置bitmap 与 slots
+    RmPageHandle rph(&file_hdr_, buffer_pool_manager_->NewPageGuarded(&pId));//新建page，并根据新建的page与file_hdr_建立页面管理
+    rph.page_hdr->next_free_page_no = -1;//下一个可用的page no（初始化为-1）
+    rph.page_hdr->num_records = 0; //page中当前分配的record个数（初始化为0）
+    
+    //3.更新file_hdr_
+    file_hdr_.num_pages ++ ;
+    file_hdr_.first_free_page_no = pId.page_no;
+    //file_hdr_.
+    return rph;
+}
+
+/**
+ * @brief 创建或获取一个空闲的page handle
+ *
+ * @return RmPageHandle 返回生成的空闲page handle
+ * @note page handle持有页面的固定和写锁
+ */
+RmPageHandle RmFileHandle::create_page_handle() {
+    // Todo:
+    // 1. 判断file_hdr_中是否还有空闲页
+    //     1.1 没有空闲页：使用缓冲池来创建一个新page；可直接调用create_new_page_handle()
+    //     1.2 有空闲页：直接获取第一个空闲页
+    // 2. 生成page handle并返回给上层
+
+    //1.判断file_hdr_中是否还有空闲页
+    //怎么判断是否空闲：1.pin_count? 
+    if(file_hdr_.first_free_page_no == -1) //没有空闲页
+        return create_new_page_handle();
+    else return fetch_page_handle(file_hdr_.first_free_page_no); //取该page_on 对应的pagehandl
+}
+
+/**
+ * @brief 当page handle中的page从已满变成未满的时候调用
+ *
+ * @param page_handle
+ * @note only used in delete_record()
+ */
+void RmFileHandle::release_page_handle(RmPageHandle &page_handle) {
+    // Todo:
+    // 当page从已满变成未满，考虑如何更新：
+    // 1. page_handle.page_hdr->next_free_page_no
+    // 2. file_hdr_.first_free_page_no
+    
+
+    std::swap(page_handle.page_hdr->next_free_page_no, file_hdr_.first_free_page_no);
+    
+}
+
+/**
+ * @brief 顺序扫描的预读：扫描进入已预读范围的后半段时，提示缓冲池预读下一批页面，使磁盘读入与扫描重叠
+ *
+ * @param page_no 扫描当前所在的页面
+ * @param prefetch_page_no 尚未提示缓冲池预读的第一个页面，预读后向后推进
+ */
+void RmFileHandle::read_ahead(page_id_t page_no, page_id_t *prefetch_page_no) const {
+    if(page_no + BUFFER_POOL_READ_AHEAD_PAGES / 2 >= *prefetch_page_no && *prefetch_page_no < file_hdr_.num_pages){
+        int num_pages = std::min(BUFFER_POOL_READ_AHEAD_PAGES, file_hdr_.num_pages - *prefetch_page_no);
+        buffer_pool_manager_->Prefetch(PageId{fd_, *prefetch_page_no}, num_pages);
+        *prefetch_page_no += num_pages;
+    }
+}
+
+/**
+ * @brief 从文件中读出file_hdr_，兼容增加分槽布局、页面校验和之前创建的文件
+ * @note 旧文件头较短，文件短于完整的文件头时只读文件中已有的部分(至少RM_LEGACY_FILE_HDR_SIZE字节)；
+ * 有数据页的旧文件中文件头之后是全0的空洞，读出的layout、page_checksum为0。
+ * 不是分槽布局的文件都按定长布局处理，没有溢出页面；没有标记page_checksum的文件不带校验和，页面布局不变
+ */
+void RmFileHandle::load_file_hdr() {
+    file_hdr_.layout = RM_LAYOUT_FIXED;
+    file_hdr_.first_free_overflow_page_no = RM_NO_PAGE;
+    file_hdr_.page_checksum = 0;
+    int file_size = disk_manager_->GetFileSize(disk_manager_->GetFileName(fd_));
+    int hdr_size = std::max(RM_LEGACY_FILE_HDR_SIZE, std::min(file_size, static_cast<int>(sizeof(file_hdr_))));
+    disk_manager_->read_page(fd_, RM_FILE_HDR_PAGE, reinterpret_cast<char *>(&file_hdr_), hdr_size);
+    if (file_hdr_.layout != RM_LAYOUT_SLOTTED) {
+        file_hdr_.layout = RM_LAYOUT_FIXED;
+        file_hdr_.first_free_overflow_page_no = RM_NO_PAGE;
+    }
+    file_hdr_.page_checksum = file_hdr_.page_checksum != 0;
+}
+
+/**
+ * @brief 检查要插入或更新的记录长度：定长布局必须等于record_size，分槽布局为[1, record_size]
+ */
+void RmFileHandle::check_record_size(int size) const {
+    if(size < 1 || size > file_hdr_.record_size || (!is_slotted() && size != file_hdr_.record_size)){
+        throw InvalidRecordSizeError(size);
+    }
+}
+
+/**
+ * @brief 在分槽布局的文件中插入一条记录
+ * @note 先尝试空闲页链表的第一页；放不下时，若该页剩余空间已经很少就把它移出链表再试下一页，
+ * 否则保留它(还能放下较短的记录)，为这条记录新建一页
+ */
+Rid RmFileHandle::insert_slotted_record(const char *buf, int size) {
+    RmOverflowRef ref{};
+    bool overflow = size > RM_SLOTTED_MAX_INLINE_SIZE;
+    if(overflow){ //较长的记录放在溢出页面中，分槽页面中只留下引用
+        ref = write_overflow(buf, size);
+        buf = reinterpret_cast<const char *>(&ref);
+        size = sizeof(ref);
+    }
+    while(file_hdr_.first_free_page_no != RM_NO_PAGE){
+        page_id_t page_no = file_hdr_.first_free_page_no;
+        RmPageHandle rph = fetch_page_handle(page_no);
+        char *data = rph.page->GetData();
+        RmSlottedPageHdr *page_hdr = SlottedPage::hdr(data);
+        int slot_no = SlottedPage::insert(data, buf, size, overflow);
+        if(slot_no != -1){
+            if(page_hdr->free_bytes < RM_SLOTTED_MIN_FREE_BYTES) pop_free_page(page_hdr);
+            return Rid{page_no, slot_no};
+        }
+        if(page_hdr->free_bytes >= RM_SLOTTED_MIN_FREE_BYTES) break;
+        pop_free_page(page_hdr);
+    }
+
+    PageId pId;
+    pId.fd = fd_;
+    RmPageHandle rph(&file_hdr_, buffer_pool_manager_->NewPageGuarded(&pId));
+    file_hdr_.num_pages ++ ;
+    char *data = rph.page->GetData();
+    SlottedPage::init(data);
+    int slot_no = SlottedPage::insert(data, buf, size, overflow); //不超过RM_SLOTTED_MAX_INLINE_SIZE，空页面一定放得下
+    RmSlottedPageHdr *page_hdr = SlottedPage::hdr(data);
+    if(page_hdr->free_bytes >= RM_SLOTTED_MIN_FREE_BYTES) push_free_page(pId.page_no, page_hdr);
+    return Rid{pId.page_no, slot_no};
+}
+
+/**
+ * @brief 更新分槽布局中的记录：页内放得下时在页内重新放置(可能整理页面)，否则改存到溢出页面，rid不变
+ */
+void RmFileHandle::update_slotted_record(const Rid &rid, const char *buf, int size) {
+    RmPageHandle rph = fetch_page_handle(rid.page_no);
+    char *data = rph.page->GetData();
+    if(!SlottedPage::is_record(data, rid.slot_no)){
+        throw RecordNotFoundError(rid.page_no, rid.slot_no);
+    }
+    put_slotted_record(data, rid.slot_no, buf, size); //已有记录改成溢出引用总能原地放下
+    RmSlottedPageHdr *page_hdr = SlottedPage::hdr(data);
+    if(!page_hdr->in_free_list && page_hdr->free_bytes >= RM_SLOTTED_MIN_FREE_BYTES){
+        push_free_page(rid.page_no, page_hdr);
+    }
+}
+
+/**
+ * @brief 把size字节的记录写入分槽页面的slot_no：槽中已有记录时替换它，否则放入该空槽；
+ * 记录较长或页内放不下时存到溢出页面，槽中只留下引用
+ * @note 先写好新记录的溢出页面并更新槽，最后才释放旧记录的溢出页面，写溢出页面失败时旧记录仍然完整
+ * @return 空槽所在的页面连溢出引用都放不下时返回false，页面和溢出页面都不变
+ */
+bool RmFileHandle::put_slotted_record(char *data, int slot_no, const char *buf, int size) {
+    bool old_overflow = SlottedPage::is_record(data, slot_no) && SlottedPage::is_overflow(data, slot_no);
+    RmOverflowRef old_ref{};
+    if(old_overflow){
+        memcpy(&old_ref, SlottedPage::get_record(data, slot_no), sizeof(old_ref));
+    }
+    if(size > RM_SLOTTED_MAX_INLINE_SIZE || !SlottedPage::place(data, slot_no, buf, size, false)){
+        RmOverflowRef ref = write_overflow(buf, size);
+        if(!SlottedPage::place(data, slot_no, reinterpret_cast<const char *>(&ref), sizeof(ref), true)){
+            free_overflow(ref);
+            return false;
+        }
+    }
+    if(old_overflow){
+        free_overflow(old_ref);
+    }
+    return true;
+}
+
+/**
+ * @brief 删除分槽布局中的记录，释放它的溢出页面；页面空闲空间足够时重新挂到空闲页链表上
+ */
+void RmFileHandle::delete_slotted_record(const Rid &rid) {
+    RmPageHandle rph = fetch_page_handle(rid.page_no);
+    char *data = rph.page->GetData();
+    if(!SlottedPage::is_record(data, rid.slot_no)){
+        throw RecordNotFoundError(rid.page_no, rid.slot_no);
+    }
+    if(SlottedPage::is_overflow(data, rid.slot_no)){
+        RmOverflowRef ref;
+        memcpy(&ref, SlottedPage::get_record(data, rid.slot_no), sizeof(ref));
+        free_overflow(ref);
+    }
+    SlottedPage::erase(data, rid.slot_no);
+    RmSlottedPageHdr *page_hdr = SlottedPage::hdr(data);
+    if(!page_hdr->in_free_list && page_hdr->free_bytes >= RM_SLOTTED_MIN_FREE_BYTES){
+        push_free_page(rid.page_no, page_hdr);
+    }
+}
+
+/**
+ * @brief 分槽页面中一条记录的只读视图，调用者持有该页面的读锁
+ * @return 页内记录直接指向帧、不持有guard；溢出记录拼接成副本
+ */
+RecordView RmFileHandle::slotted_record_view(const char *data, const Rid &rid) const {
+    int slot_no = rid.slot_no;
+    if(!SlottedPage::is_record(data, slot_no)){
+        throw RecordNotFoundError(rid.page_no, slot_no);
+    }
+    if(!SlottedPage::is_overflow(data, slot_no)){
+        return RecordView(SlottedPage::get_record(data, slot_no), SlottedPage::record_size(data, slot_no));
+    }
+    RmOverflowRef ref;
+    memcpy(&ref, SlottedPage::get_record(data, slot_no), sizeof(ref));
+    std::unique_ptr<char[]> buffer(new char[ref.size]);
+    read_overflow(ref, buffer.get());
+    return RecordView(std::move(buffer), ref.size);
+}
+
+/**
+ * @brief 把位于空闲页链表表头的分槽页面移出链表
+ */
+void RmFileHandle::pop_free_page(RmSlottedPageHdr *page_hdr) {
+    file_hdr_.first_free_page_no = page_hdr->next_free_page_no;
+    page_hdr->next_free_page_no = RM_NO_PAGE;
+    page_hdr->in_free_list = false;
+}
+
+void RmFileHandle::push_free_page(page_id_t page_no, RmSlottedPageHdr *page_hdr) {
+    page_hdr->next_free_page_no = file_hdr_.first_free_page_no;
+    page_hdr->in_free_list = true;
+    file_hdr_.first_free_page_no = page_no;
+}
+
+/**
+ * @brief 获取一个溢出页面：优先复用已释放的溢出页面，否则在文件末尾新建
+ *
+ * @param page_no 输出：溢出页面的页号
+ * @return WritePageGuard 持有该页面的固定和写锁，页面已初始化为空的溢出页面
+ */
+WritePageGuard RmFileHandle::new_overflow_page(page_id_t *page_no) {
+    WritePageGuard guard;
+    if(file_hdr_.first_free_overflow_page_no != RM_NO_PAGE){
+        *page_no = file_hdr_.first_free_overflow_page_no;
+        guard = buffer_pool_manager_->FetchPageWrite(PageId{fd_, *page_no});
+        file_hdr_.first_free_overflow_page_no = SlottedPage::overflow_hdr(guard.GetPage()->GetData())->next_page_no;
+    }else{
+        PageId pId;
+        pId.fd = fd_;
+        guard = buffer_pool_manager_->NewPageGuarded(&pId);
+        file_hdr_.num_pages ++ ;
+        *page_no = pId.page_no;
+    }
+    SlottedPage::init_overflow(guard.GetPage()->GetData());
+    return guard;
+}
+
+/**
+ * @brief 把记录分段写入一串溢出页面
+ * @return RmOverflowRef 记录的长度和第一个溢出页面
+ */
+RmOverflowRef RmFileHandle::write_overflow(const char *buf, int size) {
+    RmOverflowRef ref{size, RM_NO_PAGE};
+    WritePageGuard prev;
+    for(int offset = 0; offset < size; offset += SlottedPage::OVERFLOW_CAPACITY){
+        page_id_t page_no;
+        WritePageGuard guard = new_overflow_page(&page_no);
+        char *data = guard.GetPage()->GetData();
+        RmOverflowPageHdr *page_hdr = SlottedPage::overflow_hdr(data);
+        page_hdr->data_size = std::min(SlottedPage::OVERFLOW_CAPACITY, size - offset);
+        memcpy(data + SlottedPage::OVERFLOW_DATA_BEGIN, buf + offset, page_hdr->data_size);
+        if(prev.GetPage() == nullptr){
+            ref.first_page_no = page_no;
+        }else{
+            SlottedPage::overflow_hdr(prev.GetPage()->GetData())->next_page_no = page_no;
+        }
+        prev = std::move(guard); //上一页的next_page_no确定之后才释放它
+    }
+    return ref;
+}
+
+/**
+ * @brief 沿溢出页面链表把记录拼接到buf中，buf至少有ref.size字节
+ */
+void RmFileHandle::read_overflow(const RmOverflowRef &ref, char *buf) const {
+    int offset = 0;
+    for(page_id_t page_no = ref.first_page_no; page_no != RM_NO_PAGE && offset < ref.size;){
+        ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(PageId{fd_, page_no});
+        const char *data = guard.GetPage()->GetData();
+        const RmOverflowPageHdr *page_hdr = SlottedPage::overflow_hdr(data);
+        int len = std::min(page_hdr->data_size, ref.size - offset);
+        memcpy(buf + offset, data + SlottedPage::OVERFLOW_DATA_BEGIN, len);
+        offset += len;
+        page_no = page_hdr->next_page_no;
+    }
+    if(offset != ref.size){
+        throw InternalError("RmFileHandle::read_overflow: overflow chain is shorter than the record");
+    }
+}
+
+/**
+ * @brief 把记录的溢出页面挂到已释放溢出页面链表上，之后的溢出记录复用这些页面
+ */
+void RmFileHandle::free_overflow(const RmOverflowRef &ref) {
+    page_id_t page_no = ref.first_page_no;
+    while(page_no != RM_NO_PAGE){
+        WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(PageId{fd_, page_no});
+        RmOverflowPageHdr *page_hdr = SlottedPage::overflow_hdr(guard.GetPage()->GetData());
+        page_id_t next_page_no = page_hdr->next_page_no;
+        page_hdr->next_page_no = file_hdr_.first_free_overflow_page_no;
+        page_hdr->data_size = 0;
+        file_hdr_.first_free_overflow_page_no = page_no;
+        page_no = next_page_no;
+    }
+}
+
+// used for recovery (lab4)
+void RmFileHandle::insert_record(const Rid &rid, char *buf) {
+    insert_record(rid, buf, file_hdr_.record_size);
+}
+
+/**
+ * @brief 把size字节的记录写到指定的rid(重做日志时使用)，长度限制同insert_record
+ * @note 分槽布局中rid所在页面超出文件时先扩展文件；该槽已有记录时按更新处理，旧记录的溢出页面在新记录写好之后释放
+ */
+void RmFileHandle::insert_record(const Rid &rid, const char *buf, int size) {
+    check_record_size(size);
+    if (is_slotted()) {
+        while (rid.page_no >= file_hdr_.num_pages) {  // 扩展出的页面都是空的分槽页面，挂到空闲页链表上
+            PageId pId;
+            pId.fd = fd_;
+            RmPageHandle rph(&file_hdr_, buffer_pool_manager_->NewPageGuarded(&pId));
+            file_hdr_.num_pages++;
+            char *data = rph.page->GetData();
+            SlottedPage::init(data);
+            push_free_page(pId.page_no, SlottedPage::hdr(data));
+        }
+        RmPageHandle pageHandle = fetch_page_handle(rid.page_no);
+        char *data = pageHandle.page->GetData();
+        if (SlottedPage::hdr(data)->page_type != RM_PAGE_SLOTTED) {
+            SlottedPage::init(data);
+        }
+        if (!put_slotted_record(data, rid.slot_no, buf, size)) {
+            throw InternalError("RmFileHandle::insert_record: no room for the record in its page");
+        }
+        RmSlottedPageHdr *page_hdr = SlottedPage::hdr(data);
+        if (!page_hdr->in_free_list && page_hdr->free_bytes >= RM_SLOTTED_MIN_FREE_BYTES) {
+            push_free_page(rid.page_no, page_hdr);
+        }
+        return;
+    }
+    if (rid.page_no < file_hdr_.num_pages) {
+        create_new_page_handle();
+    }
+    RmPageHandle pageHandle = fetch_page_handle(rid.page_no);
+    Bitmap::set(pageHandle.bitmap, rid.slot_no);
+    pageHandle.page_hdr->num_records++;
+    if (pageHandle.page_hdr->num_records == file_hdr_.num_records_per_page) {
+        file_hdr_.first_free_page_no = pageHandle.page_hdr->next_free_page_no;
+    }
+
+    char *slot = pageHandle.get_slot(rid.slot_no);
+    memcpy(slot, buf, file_hdr_.record_size);
+}
+
+RmBulkLoader::RmBulkLoader(RmFileHandle *file_handle, int batch_pages)
+    : file_handle_(file_handle),
+      buffer_(std::max(batch_pages, 1), false, false),
+      batch_pages_(std::max(batch_pages, 1)),
+      first_page_no_(file_handle->file_hdr_.num_pages) {
+    if (file_handle->is_slotted()) {
+        throw InternalError("RmBulkLoader: only fixed-length record files can be bulk loaded");
+    }
+}
+
+/**
+ * @brief 没有finish()时放弃本次加载：已写入的页面在file_hdr_.num_pages之外，不会被读到，把页号分配退回到加载之前
+ */
+RmBulkLoader::~RmBulkLoader() {
+    if (!finished_) {
+        file_handle_->disk_manager_->set_fd2pageno(file_handle_->fd_, file_handle_->file_hdr_.num_pages);
+    }
+}
+
+Rid RmBulkLoader::append(const char *buf) {
+    const RmFileHdr &file_hdr = file_handle_->file_hdr_;
+    if (num_pages_ == 0 || slot_no_ == file_hdr.num_records_per_page) {
+        if (num_pages_ == batch_pages_) {
+            flush();
+        }
+        start_page();
+    }
+    char *data = current_page();
+    auto *page_hdr = reinterpret_cast<RmPageHdr *>(data + file_hdr.page_hdr_offset());
+    char *bitmap = data + file_hdr.page_hdr_offset() + sizeof(RmPageHdr);
+    char *slots = bitmap + file_hdr.bitmap_size;
+    memcpy(slots + slot_no_ * file_hdr.record_size, buf, file_hdr.record_size);
+    Bitmap::set(bitmap, slot_no_);
+    page_hdr->num_records++;
+    return Rid{first_page_no_ + num_pages_ - 1, slot_no_++};
+}
+
+/**
+ * @brief 把最后一批页面写入文件并落盘，然后更新file_hdr_并写回文件头，写回文件头之后加载的记录才对文件可见
+ * @note 最后一页未满时挂到空闲页链表的表头，之后的insert_record先填满它
+ */
+void RmBulkLoader::finish() {
+    if (finished_) {
+        return;
+    }
+    RmFileHdr &file_hdr = file_handle_->file_hdr_;
+    if (num_pages_ > 0 && slot_no_ < file_hdr.num_records_per_page) {
+        auto *page_hdr = reinterpret_cast<RmPageHdr *>(current_page() + file_hdr.page_hdr_offset());
+        page_hdr->next_free_page_no = file_hdr.first_free_page_no;
+        file_hdr.first_free_page_no = first_page_no_ + num_pages_ - 1;
+    }
+    flush();
+    DiskManager *disk_manager = file_handle_->disk_manager_;
+    int fd = file_handle_->fd_;
+    disk_manager->sync_file(fd);
+    file_hdr.num_pages = first_page_no_;
+    disk_manager->write_page(fd, RM_FILE_HDR_PAGE, reinterpret_cast<char *>(&file_hdr), sizeof(file_hdr));
+    disk_manager->sync_file(fd);
+    finished_ = true;
+}
+
+void RmBulkLoader::start_page() {
+    num_pages_++;
+    slot_no_ = 0;
+    char *data = current_page();
+    memset(data, 0, PAGE_SIZE);
+    auto *page_hdr = reinterpret_cast<RmPageHdr *>(data + file_handle_->file_hdr_.page_hdr_offset());
+    page_hdr->next_free_page_no = RM_NO_PAGE;
+    page_hdr->num_records = 0;
+}
+
+/**
+ * @brief 在文件末尾分配连续页号，把缓冲区中的页面计算校验和后用一次批量I/O写入
+ */
+void RmBulkLoader::flush() {
+    if (num_pages_ == 0) {
+        return;
+    }
+    DiskManager *disk_manager = file_handle_->disk_manager_;
+    int fd = file_handle_->fd_;
+    page_id_t page_no = disk_manager->AllocatePages(fd, num_pages_);
+    if (page_no != first_page_no_) {
+        throw InternalError("RmBulkLoader: pages of the file were allocated by others during bulk load");
+    }
+    bool checksum = disk_manager->has_page_checksum(fd);
+    std::vector<PageIORequest> requests;
+    requests.reserve(num_pages_);
+    for (int i = 0; i < num_pages_; i++) {
+        char *data = buffer_.GetFrame(i);
+        if (checksum) {
+            Page::SetChecksum(data);
+        }
+        requests.push_back({fd, first_page_no_ + i, data});
+    }
+    disk_manager->write_pages(std::move(requests));
+    first_page_no_ += num_pages_;
+    num_pages_ = 0;
+}
+
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <assert.h>
+
+#include <memory>
+#include <utility>
+
+#include "bitmap.h"
+#include "common/context.h"
+#include "rm_defs.h"
+#include "slotted_page.h"
+
+class RmManager;
+
+// 对单个page进行封装，用page中的data存RmPageHdr, bitmap, slots的数据
+// 由guard构造的page handle持有页面的固定和读/写锁，析构时自动释放；由Page*构造的不持有
+struct RmPageHandle {
+    const RmFileHdr *file_hdr;  // 用到了file_hdr的bitmap_size, record_size
+    Page *page;                 // 指向单个page
+    RmPageHdr *page_hdr;        // page->data的第一部分，指针指向首地址，长度为sizeof(RmPageHdr)
+    char *bitmap;               // page->data的第二部分，指针指向首地址，长度为file_hdr->bitmap_size
+    char *slots;  // page->data的第三部分，指针指向首地址，每个slot的长度为file_hdr->record_size
+    ReadPageGuard read_guard;    // 只读访问时持有
+    WritePageGuard write_guard;  // 修改页面时持有
+
+    RmPageHandle(const RmFileHdr *fhdr_, Page *page_) : file_hdr(fhdr_), page(page_) {
+        page_hdr = reinterpret_cast<RmPageHdr *>(page->GetData() + file_hdr->page_hdr_offset());
+        bitmap = page->GetData() + sizeof(RmPageHdr) + file_hdr->page_hdr_offset();
+        slots = bitmap + file_hdr->bitmap_size;
+    }
+
+    RmPageHandle(const RmFileHdr *fhdr_, ReadPageGuard &&guard) : RmPageHandle(fhdr_, guard.GetPage()) {
+        read_guard = std::move(guard);
+    }
+
+    RmPageHandle(const RmFileHdr *fhdr_, WritePageGuard &&guard) : RmPageHandle(fhdr_, guard.GetPage()) {
+        write_guard = std::move(guard);
+    }
+
+    // 返回位于slot_no的record的地址
+    char *get_slot(int slot_no) const {
+        return slots + slot_no * file_hdr->record_size;  // slots的首地址 + slot个数 * 每个slot的大小(每个record的大小)
+    }
+};
+
+// 记录的只读视图，不持有页面的固定或锁
+// 由get_record_view返回的视图指向加读锁时复制出的副本(buffer)，视图存在期间可以修改该页面；
+// 由RmScan::record返回的视图指向扫描持有读锁时复制到扫描缓冲区的副本，扫描的下一次record()或next()之后失效
+// 分槽布局中存放在溢出页面上的记录不连续，视图指向拼接出的副本(buffer)
+// 记录需要在算子之外保留时(如作为结果向上返回)再用to_record()复制一份
+struct RecordView {
+    const char *data = nullptr;  // 指向记录的副本
+    int size = 0;                // 定长布局中等于file_hdr的record_size，分槽布局中为记录的实际长度
+    std::unique_ptr<char[]> buffer;  // 视图自己持有的副本，借用扫描的缓冲区时为空
+
+    RecordView() = default;
+
+    RecordView(const char *data_, int size_) : data(data_), size(size_) {}
+
+    RecordView(std::unique_ptr<char[]> buffer_, int size_)
+        : data(buffer_.get()), size(size_), buffer(std::move(buffer_)) {}
+
+    // 复制出一条独立的记录
+    std::unique_ptr<RmRecord> to_record() const { return std::make_unique<RmRecord>(size, const_cast<char *>(data)); }
+};
+
+// 每个RmFileHandle对应一个文件，里面有多个page，每个page的数据封装在RmPageHandle
+class RmFileHandle {      // TableHeap
+    friend class RmScan;  // TableIterator
+    friend class RmBatchScan;
+    friend class RmBulkLoader;
+    friend class RmManager;
+
+   private:
+    DiskManager *disk_manager_;
+    BufferPoolManager *buffer_pool_manager_;
+    int fd_;
+    /** @brief file_hdr中的num_pages记录此文件分配的page个数
+     * page_no范围为[0,file_hdr.num_pages)，page_no从0开始增加，其中第0页存file_hdr，从第1页开始存page_handle
+     * 在page_handle中有page_hdr.free_page_no存第一个可用(未满)的page_no
+     * */
+    RmFileHdr file_hdr_;
+
+   public:
+    RmFileHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd)
+        : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), fd_(fd) {
+        // 注意：这里从磁盘中读出文件描述符为fd的文件的file_hdr，读到内存中
+        // 这里实际就是初始化file_hdr，只不过是从磁盘中读出进行初始化
+        // init file_hdr_
+        load_file_hdr();
+        // disk_manager管理的fd对应的文件中，设置从file_hdr_.num_pages开始分配page_no
+        disk_manager_->set_fd2pageno(fd, file_hdr_.num_pages);
+        // 文件头标记了带校验和的文件，由缓冲池写回时计算、读入时校验
+        disk_manager_->set_page_checksum(fd, file_hdr_.page_checksum != 0);
+    }
+
+    DISALLOW_COPY(RmFileHandle);
+    // RmFileHandle(const RmFileHandle &other) = delete;
+    // RmFileHandle &operator=(const RmFileHandle &other) = delete;
+
+    RmFileHdr get_file_hdr() { return file_hdr_; }
+    int GetFd() { return fd_; }
+
+    // 是否是分槽布局(变长记录)的文件
+    bool is_slotted() const { return file_hdr_.layout == RM_LAYOUT_SLOTTED; }
+
+    bool is_record(const Rid &rid) const {
+        RmPageHandle page_handle = fetch_read_page_handle(rid.page_no);
+        if (is_slotted()) {
+            return SlottedPage::is_record(page_handle.page->GetData(), rid.slot_no);
+        }
+        return Bitmap::is_set(page_handle.bitmap, rid.slot_no);  // page的slot_no位置上是否有record
+    }
+
+    std::unique_ptr<RmRecord> get_record(const Rid &rid, Context *context) const;
+
+    RecordView get_record_view(const Rid &rid, Context *context) const;
+
+    Rid insert_record(char *buf, Context *context);
+
+    // 插入一条size字节的记录；定长布局中size必须等于record_size，分槽布局中不超过record_size
+    Rid insert_record(const char *buf, int size, Context *context);
+
+    void insert_record(const Rid &rid, char *buf);
+
+    // 把size字节的记录写到指定的rid，长度限制同insert_record
+    void insert_record(const Rid &rid, const char *buf, int size);
+
+    void delete_record(const Rid &rid, Context *context);
+
+    void update_record(const Rid &rid, char *buf, Context *context);
+
+    // 把记录更新为size字节的新记录，长度限制同insert_record；记录的rid不变
+    void update_record(const Rid &rid, const char *buf, int size, Context *context);
+
+    RmPageHandle create_new_page_handle();
+
+    RmPageHandle fetch_page_handle(int page_no) const;
+
+    RmPageHandle fetch_read_page_handle(int page_no) const;
+
+   private:
+    RmPageHandle create_page_handle();
+
+    void release_page_handle(RmPageHandle &page_handle);
+
+    void read_ahead(page_id_t page_no, page_id_t *prefetch_page_no) const;
+
+    void load_file_hdr();
+
+    void check_record_size(int size) const;
+
+    Rid insert_slotted_record(const char *buf, int size);
+
+    void update_slotted_record(const Rid &rid, const char *buf, int size);
+
+    bool put_slotted_record(char *data, int slot_no, const char *buf, int size);
+
+    void delete_slotted_record(const Rid &rid);
+
+    RecordView slotted_record_view(const char *data, const Rid &rid) const;
+
+    void pop_free_page(RmSlottedPageHdr *page_hdr);
+
+    void push_free_page(page_id_t page_no, RmSlottedPageHdr *page_hdr);
+
+    WritePageGuard new_overflow_page(page_id_t *page_no);
+
+    RmOverflowRef write_overflow(const char *buf, int size);
+
+    void read_overflow(const RmOverflowRef &ref, char *buf) const;
+
+    void free_overflow(const RmOverflowRef &ref);
+};
+
+// 批量追加记录：在私有缓冲区中直接填充新页面，攒满batch_pages页后按连续页号一次写入文件末尾，不经过缓冲池；
+// 全部追加完后由finish()把数据页落盘，再一次性更新并写回file_hdr_(含空闲页链表)，写回file_hdr_之前新页面对文件不可见
+// 加载期间该文件不能有其他插入、删除或扫描；没有调用finish()就析构相当于放弃本次加载
+// 只支持定长布局的文件
+class RmBulkLoader {
+   public:
+    explicit RmBulkLoader(RmFileHandle *file_handle, int batch_pages = RM_BULK_LOAD_BATCH_PAGES);
+
+    ~RmBulkLoader();
+
+    DISALLOW_COPY(RmBulkLoader);
+
+    // 追加一条记录，返回它将要占用的位置
+    Rid append(const char *buf);
+
+    void finish();
+
+   private:
+    char *current_page() const { return buffer_.GetFrame(num_pages_ - 1); }
+
+    void start_page();
+
+    void flush();
+
+    RmFileHandle *file_handle_;
+    FrameArena buffer_;         // batch_pages_个PAGE_SIZE对齐的页面，满足O_DIRECT的对齐要求
+    int batch_pages_;
+    page_id_t first_page_no_;   // 缓冲区第0页对应的页号
+    int num_pages_ = 0;         // 缓冲区中已经开始填充的页数
+    int slot_no_ = 0;           // 当前页面中下一条记录的slot
+    bool finished_ = false;
+};
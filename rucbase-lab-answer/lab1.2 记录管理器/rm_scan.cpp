@@ -1,51 +1,159 @@
-#include "rm_scan.h"
-
-#include "rm_file_handle.h"
-
-/**
- * @brief 初始化file_handle和rid
- *
- * @param file_handle
- */
-RmScan::RmScan(const RmFileHandle *file_handle) : file_handle_(file_handle) {
-    // Todo:
-    // 初始化file_handle和rid（指向第一个存放了记录的位置）
-    rid_ = {RM_FIRST_RECORD_PAGE, -1}; //起始页
-    next(); //指向第一个存放了记录的位置
-}
-
-/**
- * @brief 找到文件中下一个存放了记录的位置
- */
-void RmScan::next() {
-    // Todo:
-    // 找到文件中下一个存放了记录的非空闲位置，用rid_来指向这个位置
-    while(rid_.page_no < file_handle_->file_hdr_.num_pages){
-        RmPageHandle rph = file_handle_->fetch_page_handle(rid_.page_no);
-        int slot_no = Bitmap::next_bit(true, rph.bitmap, file_handle_->file_hdr_.num_records_per_page, rid_.slot_no); //找到第一个非空闲位
-        rid_.slot_no = slot_no;
-        if(slot_no < file_handle_->file_hdr_.num_records_per_page) //指向
-            return ;
-        rid_.slot_no = -1;
-        rid_.page_no ++ ; //找下一页面
-    }
-    rid_ = {-1, -1};
-
-}
-
-/**
- * @brief ​ 判断是否到达文件末尾
- */
-bool RmScan::is_end() const {
-    // Todo: 修改返回值
-    if(rid_.page_no != RM_NO_PAGE) return false;
-    return true;
-}
-
-/**
- * @brief RmScan内部存放的rid
- */
-Rid RmScan::rid() const {
-    // Todo: 修改返回值
-    return rid_;
-}
\ No newline at end of file
+#include "rm_scan.h"
+
+#include <algorithm>
+
+#include "rm_file_handle.h"
+
+/**
+ * @brief 初始化file_handle和rid
+ *
+ * @param file_handle
+ */
+RmScan::RmScan(const RmFileHandle *file_handle) : file_handle_(file_handle) {
+    // Todo:
+    // 初始化file_handle和rid（指向第一个存放了记录的位置）
+    rid_ = {RM_FIRST_RECORD_PAGE, -1}; //起始页
+    prefetch_page_no_ = RM_FIRST_RECORD_PAGE + 1; //起始页由next()同步读入，从下一页开始预读
+    record_buf_.reset(new char[file_handle_->file_hdr_.record_size]);
+    next(); //指向第一个存放了记录的位置
+}
+
+/**
+ * @brief 找到文件中下一个存放了记录的位置
+ * @note 同一页面上的查找持有读锁，返回前释放；两次调用之间页面可能被修改，每次都重新读取bitmap或槽目录
+ */
+void RmScan::next() {
+    // Todo:
+    // 找到文件中下一个存放了记录的非空闲位置，用rid_来指向这个位置
+    while(rid_.page_no < file_handle_->file_hdr_.num_pages){
+        file_handle_->read_ahead(rid_.page_no, &prefetch_page_no_); //预读后面的页面，使磁盘读入与扫描重叠
+        if(page_guard_.GetPage() == nullptr){ //进入新页面时才固定页面，同一页面上的记录都在帧中直接读取
+            page_guard_ = file_handle_->buffer_pool_manager_->FetchPageBasic(PageId{file_handle_->fd_, rid_.page_no});
+            RmPageHandle rph(&file_handle_->file_hdr_, page_guard_.GetPage());
+            bitmap_ = rph.bitmap;
+            slots_ = rph.slots;
+            page_data_ = rph.page->GetData();
+        }
+        Page *page = page_guard_.GetPage();
+        page->RLatch();
+        if(file_handle_->is_slotted()){ //分槽布局按槽目录查找，溢出页面中没有记录
+            rid_.slot_no = SlottedPage::next_record(page_data_, rid_.slot_no);
+        }else{
+            int slot_no = Bitmap::next_bit(true, bitmap_, file_handle_->file_hdr_.num_records_per_page, rid_.slot_no); //找到第一个非空闲位
+            rid_.slot_no = slot_no < file_handle_->file_hdr_.num_records_per_page ? slot_no : -1;
+        }
+        page->RUnlatch();
+        if(rid_.slot_no != -1) //指向
+            return ;
+        rid_.page_no ++ ; //找下一页面
+        page_guard_.Drop(); //先释放当前页面，不同时固定两个页面
+    }
+    rid_ = {-1, -1};
+
+}
+
+/**
+ * @brief ​ 判断是否到达文件末尾
+ */
+bool RmScan::is_end() const {
+    // Todo: 修改返回值
+    if(rid_.page_no != RM_NO_PAGE) return false;
+    return true;
+}
+
+/**
+ * @brief RmScan内部存放的rid
+ */
+Rid RmScan::rid() const {
+    // Todo: 修改返回值
+    return rid_;
+}
+
+/**
+ * @brief 当前记录的只读视图：持有读锁把记录复制到扫描自己的缓冲区，不分配内存
+ * @note 视图指向扫描的缓冲区，下一次record()或next()之后失效；需要保留记录时调用RecordView::to_record()
+ * 分槽布局中的溢出记录拼接成副本返回；next()之后记录被删除时，分槽布局抛出RecordNotFoundError，定长布局返回删除前的内容
+ */
+RecordView RmScan::record() const {
+    Page *page = page_guard_.GetPage();
+    page->RLatch();
+    RecordView view;
+    try {
+        if(file_handle_->is_slotted()){
+            view = file_handle_->slotted_record_view(page_data_, rid_);
+        }else{
+            view = RecordView(slots_ + rid_.slot_no * file_handle_->file_hdr_.record_size, file_handle_->file_hdr_.record_size);
+        }
+    } catch (...) {
+        page->RUnlatch();
+        throw;
+    }
+    if(view.buffer == nullptr){ //指向帧中的记录，释放读锁之前复制出来
+        memcpy(record_buf_.get(), view.data, view.size);
+        view = RecordView(record_buf_.get(), view.size);
+    }
+    page->RUnlatch();
+    return view;
+}
+
+/**
+ * @brief 初始化按页批量扫描，从第一个存放记录的页面开始
+ */
+RmBatchScan::RmBatchScan(const RmFileHandle *file_handle)
+    : file_handle_(file_handle), page_no_(RM_FIRST_RECORD_PAGE), prefetch_page_no_(RM_FIRST_RECORD_PAGE + 1) {}
+
+/**
+ * @brief 读取下一个有记录的页面中的所有记录，跳过没有记录的页面
+ *
+ * @param batch 输出：固定下一个页面并加读锁，把该页面所有记录的rid和记录副本填入batch，返回前释放页面；
+ * batch的数组在多次调用之间复用，不会每页重新分配
+ * @return 扫描结束(没有更多记录)时返回false，此时batch为空
+ */
+bool RmBatchScan::next_batch(RmPageBatch *batch) {
+    batch->data.clear();
+    batch->rids.clear();
+    batch->records.clear();
+    batch->sizes.clear();
+    batch->record_size = file_handle_->file_hdr_.record_size;
+    int num_slots = file_handle_->file_hdr_.num_records_per_page;
+    while(page_no_ < file_handle_->file_hdr_.num_pages){
+        file_handle_->read_ahead(page_no_, &prefetch_page_no_);
+        RmPageHandle rph = file_handle_->fetch_read_page_handle(page_no_); //离开本次循环时释放读锁和固定
+        if(file_handle_->is_slotted()){
+            const char *data = rph.page->GetData();
+            for(int slot_no = SlottedPage::next_record(data, -1); slot_no != -1;
+                slot_no = SlottedPage::next_record(data, slot_no)){
+                Rid rid{page_no_, slot_no};
+                RecordView view = file_handle_->slotted_record_view(data, rid);
+                batch->rids.push_back(rid);
+                batch->sizes.push_back(view.size);
+                batch->data.insert(batch->data.end(), view.data, view.data + view.size);
+            }
+        }else{
+            for(int slot_no = Bitmap::first_bit(true, rph.bitmap, num_slots); slot_no < num_slots;
+                slot_no = Bitmap::next_bit(true, rph.bitmap, num_slots, slot_no)){
+                batch->rids.push_back(Rid{page_no_, slot_no});
+            }
+            batch->data.resize(batch->rids.size() * batch->record_size);
+            if(static_cast<int>(batch->rids.size()) == num_slots){ //满页的slots是连续的，一次复制
+                memcpy(batch->data.data(), rph.slots, batch->data.size());
+            }else{
+                for(size_t i = 0; i < batch->rids.size(); i++){
+                    memcpy(batch->data.data() + i * batch->record_size, rph.get_slot(batch->rids[i].slot_no),
+                           batch->record_size);
+                }
+            }
+        }
+        page_no_++;
+        if(!batch->rids.empty()){
+            //data不再增长之后才取记录地址
+            size_t offset = 0;
+            for(size_t i = 0; i < batch->rids.size(); i++){
+                batch->records.push_back(batch->data.data() + offset);
+                offset += batch->sizes.empty() ? batch->record_size : batch->sizes[i];
+            }
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+
+#include "rm_defs.h"
+#include "rm_file_handle.h"
+
+// 扫描停在某个页面上时只持有该页面的固定，直到next()离开该页面或扫描结束；读锁只在next()和record()内部短暂持有，
+// 两次调用之间不持有，扫描期间同一线程可以读取、修改任意页面(包括扫描所在的页面)，不会与等待写锁的线程互相等待
+class RmScan : public RecScan {
+    const RmFileHandle *file_handle_;
+    Rid rid_;
+    page_id_t prefetch_page_no_;  // 尚未提示缓冲池预读的第一个页面
+    BasicPageGuard page_guard_;   // 当前页面的固定，扫描结束后为空
+    const char *bitmap_ = nullptr;  // 当前页面的bitmap
+    const char *slots_ = nullptr;   // 当前页面的slots
+    const char *page_data_ = nullptr;  // 当前页面的数据，分槽布局按槽目录查找记录
+    std::unique_ptr<char[]> record_buf_;  // record()持有读锁时把当前记录复制到这里，多次调用复用
+public:
+    RmScan(const RmFileHandle *file_handle);
+
+    void next() override;
+
+    bool is_end() const override;
+
+    Rid rid() const override;
+
+    RecordView record() const;
+};
+
+// 按页批量扫描的一批记录：一个页面中所有存放了记录的slot，按slot_no递增
+// next_batch()持有页面读锁时把记录复制到batch自己的缓冲区，返回时已经释放页面，records中的指针在下一次next_batch()之前有效
+struct RmPageBatch {
+    std::vector<char> data;  // 本批记录的副本，按rids的顺序连续存放，多次调用之间复用
+    std::vector<Rid> rids;
+    std::vector<const char *> records;  // 与rids一一对应，指向data中的记录
+    int record_size = 0;
+    std::vector<int> sizes;  // 分槽布局中每条记录的长度(溢出记录为拼接后的长度)，与rids一一对应；定长布局为空，记录长度都是record_size
+
+    size_t size() const { return rids.size(); }
+
+    // 第i条记录的只读视图，指向batch中的副本
+    RecordView record(size_t i) const { return RecordView(records[i], sizes.empty() ? record_size : sizes[i]); }
+};
+
+// 按页批量扫描：每次固定一个页面，持有读锁一次复制出该页面的所有记录，每页只查找一次缓冲池、只加一次读锁
+// 两次next_batch()之间不持有页面的固定和读锁，处理batch期间可以修改batch所在的页面
+class RmBatchScan {
+    const RmFileHandle *file_handle_;
+    page_id_t page_no_;           // 下一个要读取的页面
+    page_id_t prefetch_page_no_;  // 尚未提示缓冲池预读的第一个页面
+public:
+    explicit RmBatchScan(const RmFileHandle *file_handle);
+
+    bool next_batch(RmPageBatch *batch);
+};
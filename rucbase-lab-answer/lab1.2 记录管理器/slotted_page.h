@@ -0,0 +1,224 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+#include "rm_defs.h"
+
+static_assert(PAGE_SIZE <= RM_SLOT_OVERFLOW, "slot offsets and sizes are stored in 15 bits");
+
+/**
+ * @brief 分槽页面(RM_LAYOUT_SLOTTED)的页内布局，与Bitmap一样只提供作用在页面数据上的静态函数
+ * 页面依次为：页面头部(LSN、校验和) | RmSlottedPageHdr | 槽目录(向页尾方向增长) | 空闲空间 | 记录数据(从页尾向前增长)
+ * @note 删除、缩短记录留下的空洞计入free_bytes，连续空间放不下而free_bytes足够时先整理页面(compact)；
+ * 整理只移动记录数据、不改变槽号，记录的rid保持不变
+ */
+class SlottedPage {
+   public:
+    // 分槽布局的页面不论文件是否开启校验和，都在页面头部之前留出校验和字段
+    static constexpr int PAGE_HDR_BEGIN = static_cast<int>(Page::OFFSET_PAGE_HDR_CHECKSUM);
+    static constexpr int SLOTS_BEGIN = static_cast<int>(PAGE_HDR_BEGIN + sizeof(RmSlottedPageHdr));
+    static constexpr int OVERFLOW_DATA_BEGIN = static_cast<int>(PAGE_HDR_BEGIN + sizeof(RmOverflowPageHdr));
+    static constexpr int OVERFLOW_CAPACITY = PAGE_SIZE - OVERFLOW_DATA_BEGIN;  // 每个溢出页面存放的数据字节数
+
+    static RmSlottedPageHdr *hdr(char *data) { return reinterpret_cast<RmSlottedPageHdr *>(data + PAGE_HDR_BEGIN); }
+
+    static const RmSlottedPageHdr *hdr(const char *data) {
+        return reinterpret_cast<const RmSlottedPageHdr *>(data + PAGE_HDR_BEGIN);
+    }
+
+    static RmOverflowPageHdr *overflow_hdr(char *data) {
+        return reinterpret_cast<RmOverflowPageHdr *>(data + PAGE_HDR_BEGIN);
+    }
+
+    static const RmOverflowPageHdr *overflow_hdr(const char *data) {
+        return reinterpret_cast<const RmOverflowPageHdr *>(data + PAGE_HDR_BEGIN);
+    }
+
+    // 把新页面初始化为空的分槽页面
+    static void init(char *data) {
+        RmSlottedPageHdr *page_hdr = hdr(data);
+        page_hdr->next_free_page_no = RM_NO_PAGE;
+        page_hdr->num_records = 0;
+        page_hdr->page_type = RM_PAGE_SLOTTED;
+        page_hdr->num_slots = 0;
+        page_hdr->data_begin = PAGE_SIZE;
+        page_hdr->free_bytes = PAGE_SIZE - SLOTS_BEGIN;
+        page_hdr->in_free_list = false;
+    }
+
+    // 把新页面初始化为空的溢出页面
+    static void init_overflow(char *data) {
+        RmOverflowPageHdr *page_hdr = overflow_hdr(data);
+        page_hdr->next_page_no = RM_NO_PAGE;
+        page_hdr->data_size = 0;
+        page_hdr->page_type = RM_PAGE_OVERFLOW;
+    }
+
+    // 如果slot_no上存放了记录，则返回true；溢出页面和未初始化的页面中没有记录
+    static bool is_record(const char *data, int slot_no) {
+        const RmSlottedPageHdr *page_hdr = hdr(data);
+        return page_hdr->page_type == RM_PAGE_SLOTTED && slot_no >= 0 && slot_no < page_hdr->num_slots &&
+               slot(data, slot_no).offset != 0;
+    }
+
+    /**
+     * @brief 找下一个存放了记录的槽
+     * @return 找到了就返回槽号，没找到(或者不是分槽页面)就返回-1
+     */
+    static int next_record(const char *data, int curr) {
+        const RmSlottedPageHdr *page_hdr = hdr(data);
+        if (page_hdr->page_type != RM_PAGE_SLOTTED) {
+            return -1;
+        }
+        for (int slot_no = curr + 1; slot_no < page_hdr->num_slots; slot_no++) {
+            if (slot(data, slot_no).offset != 0) {
+                return slot_no;
+            }
+        }
+        return -1;
+    }
+
+    static const char *get_record(const char *data, int slot_no) { return data + slot(data, slot_no).offset; }
+
+    // 槽中数据的长度，溢出记录为sizeof(RmOverflowRef)
+    static int record_size(const char *data, int slot_no) { return slot(data, slot_no).size & ~RM_SLOT_OVERFLOW; }
+
+    // 槽中存放的是否是溢出记录的RmOverflowRef
+    static bool is_overflow(const char *data, int slot_no) { return (slot(data, slot_no).size & RM_SLOT_OVERFLOW) != 0; }
+
+    /**
+     * @brief 把记录放入第一个空槽(没有空槽时在槽目录末尾增加一个)
+     * @return 记录的槽号，页面放不下时返回-1且不修改页面
+     */
+    static int insert(char *data, const char *buf, int size, bool overflow) {
+        const RmSlottedPageHdr *page_hdr = hdr(data);
+        int slot_no = 0;
+        while (slot_no < page_hdr->num_slots && slot(data, slot_no).offset != 0) {
+            slot_no++;
+        }
+        return place(data, slot_no, buf, size, overflow) ? slot_no : -1;
+    }
+
+    /**
+     * @brief 把记录放入指定的空槽，槽号超出槽目录时先扩展槽目录；槽中已有记录时等同于update
+     * @return 页面放不下时返回false且不修改页面
+     */
+    static bool place(char *data, int slot_no, const char *buf, int size, bool overflow) {
+        if (is_record(data, slot_no)) {
+            return update(data, slot_no, buf, size, overflow);
+        }
+        RmSlottedPageHdr *page_hdr = hdr(data);
+        int grow = std::max(0, slot_no + 1 - page_hdr->num_slots) * static_cast<int>(sizeof(RmSlot));
+        if (page_hdr->free_bytes < grow + stored_size(size)) {
+            return false;
+        }
+        if (page_hdr->data_begin - slots_end(data) < grow) {
+            compact(data);
+        }
+        for (; page_hdr->num_slots <= slot_no; page_hdr->num_slots++) {
+            slot(data, page_hdr->num_slots) = RmSlot{0, 0};
+        }
+        page_hdr->free_bytes -= grow;
+        write(data, slot_no, buf, size, overflow);
+        page_hdr->num_records++;
+        return true;
+    }
+
+    /**
+     * @brief 删除slot_no上的记录，槽目录末尾的空槽一并回收
+     */
+    static void erase(char *data, int slot_no) {
+        RmSlottedPageHdr *page_hdr = hdr(data);
+        release(data, slot_no);
+        page_hdr->num_records--;
+        while (page_hdr->num_slots > 0 && slot(data, page_hdr->num_slots - 1).offset == 0) {
+            page_hdr->num_slots--;
+            page_hdr->free_bytes += sizeof(RmSlot);
+        }
+    }
+
+    /**
+     * @brief 更新slot_no上的记录：不变长时原地覆盖，变长时在页内重新分配(可能触发整理)，槽号不变
+     * @return 页面放不下新记录时返回false且不修改页面
+     */
+    static bool update(char *data, int slot_no, const char *buf, int size, bool overflow) {
+        RmSlottedPageHdr *page_hdr = hdr(data);
+        RmSlot &s = slot(data, slot_no);
+        int old_size = stored_size(s.size & ~RM_SLOT_OVERFLOW);
+        int new_size = stored_size(size);
+        if (new_size <= old_size) {
+            memcpy(data + s.offset, buf, size);
+            s.size = static_cast<uint16_t>(size | (overflow ? RM_SLOT_OVERFLOW : 0));
+            page_hdr->free_bytes += old_size - new_size;  // 尾部缩短的部分成为空洞
+            return true;
+        }
+        if (page_hdr->free_bytes + old_size < new_size) {
+            return false;
+        }
+        release(data, slot_no);
+        write(data, slot_no, buf, size, overflow);
+        return true;
+    }
+
+    /**
+     * @brief 页内整理：把所有记录紧凑地移到页尾，空洞合并到槽目录与数据区之间的连续空间
+     */
+    static void compact(char *data) {
+        RmSlottedPageHdr *page_hdr = hdr(data);
+        char old_page[PAGE_SIZE];
+        memcpy(old_page, data, PAGE_SIZE);
+        int end = PAGE_SIZE;
+        for (int slot_no = 0; slot_no < page_hdr->num_slots; slot_no++) {
+            RmSlot &s = slot(data, slot_no);
+            if (s.offset == 0) {
+                continue;
+            }
+            int len = stored_size(s.size & ~RM_SLOT_OVERFLOW);
+            end -= len;
+            memcpy(data + end, old_page + s.offset, len);
+            s.offset = static_cast<uint16_t>(end);
+        }
+        page_hdr->data_begin = end;
+    }
+
+   private:
+    // 每条记录至少占sizeof(RmOverflowRef)字节，页内放不下的更新总能原地改成溢出引用
+    static int stored_size(int size) { return std::max(size, static_cast<int>(sizeof(RmOverflowRef))); }
+
+    static RmSlot &slot(char *data, int slot_no) { return reinterpret_cast<RmSlot *>(data + SLOTS_BEGIN)[slot_no]; }
+
+    static const RmSlot &slot(const char *data, int slot_no) {
+        return reinterpret_cast<const RmSlot *>(data + SLOTS_BEGIN)[slot_no];
+    }
+
+    static int slots_end(const char *data) {
+        return SLOTS_BEGIN + hdr(data)->num_slots * static_cast<int>(sizeof(RmSlot));
+    }
+
+    // 在数据区分配空间并写入记录，调用者保证free_bytes足够
+    static void write(char *data, int slot_no, const char *buf, int size, bool overflow) {
+        RmSlottedPageHdr *page_hdr = hdr(data);
+        int len = stored_size(size);
+        if (page_hdr->data_begin - slots_end(data) < len) {
+            compact(data);
+        }
+        page_hdr->data_begin -= len;
+        page_hdr->free_bytes -= len;
+        memcpy(data + page_hdr->data_begin, buf, size);
+        slot(data, slot_no) = RmSlot{static_cast<uint16_t>(page_hdr->data_begin),
+                                     static_cast<uint16_t>(size | (overflow ? RM_SLOT_OVERFLOW : 0))};
+    }
+
+    // 释放slot_no上记录的空间，槽变为空槽；记录紧挨着数据区起点时直接归还给连续空间
+    static void release(char *data, int slot_no) {
+        RmSlottedPageHdr *page_hdr = hdr(data);
+        RmSlot &s = slot(data, slot_no);
+        int len = stored_size(s.size & ~RM_SLOT_OVERFLOW);
+        if (s.offset == page_hdr->data_begin) {
+            page_hdr->data_begin += len;
+        }
+        page_hdr->free_bytes += len;
+        s = RmSlot{0, 0};
+    }
+};